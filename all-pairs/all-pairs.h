@@ -3,13 +3,20 @@
 
 #include <libdash.h>
 #include <boost/log/trivial.hpp>
+#include <mpi.h>
 
 #include <sstream>
 #include <fstream>
 #include <iomanip>
 #include <ctime>
+#include <vector>
+#include <array>
+#include <algorithm>
+#include <numeric>
+#include <random>
 
 #include "logger.h"
+#include "online-stats.h"
 
 #define VALIDATE_KERNEL 0
 
@@ -30,12 +37,40 @@ private:
 
     int                 repeats;
     bool                make_symmetric;
+    /* round robin tournament instead of the diagonals */
+    bool                tournament;
     array_t             results;
     /* summarized results */
     marray_t            medians;
     marray_t            mins;
     marray_t            maxs;
 
+    /* online statistics instead of the raw results */
+    bool                online;
+    int                 reservoir_size;
+    OnlineStats         pair_stats;
+    marray_t            means;
+    /* random subsample of the raw results of every pair */
+    array_t             reservoirs;
+
+    /* message size sweep */
+    bool                sweep = false;
+    int                 sweep_repeats;
+    std::vector<long>   sweep_sizes;
+    /* median time per message for every pair and size */
+    array_t             sweep_medians;
+    /* LogGP parameters L, o, g, G for every pair */
+    array_t             loggp;
+
+    /* measurements with all pairs of a pattern at once */
+    std::vector<std::string> contention_patterns;
+    int                 contention_draws;
+    marray_t            contention_medians;
+    /* times of this unit to every other unit over all draws of a pattern */
+    std::vector<std::vector<double>> contention_samples;
+    /* contention median divided by the isolated median */
+    marray_t            degradations;
+
     harray_t            hostnames;
 
     int                 sub_diags;
@@ -50,24 +85,36 @@ public:
     AllPairs(
         int  rep        = 50,
         int  partests   = 0,
-        bool make_sym   = false
+        bool make_sym   = false,
+        bool tourn      = false,
+        bool onl        = false,
+        int  reservoir  = 0
     ):
         repeats(rep),
         make_symmetric(make_sym),
+        tournament(tourn),
+        online(onl),
+        reservoir_size(reservoir),
+        pair_stats(0.5, reservoir, dash::myid()),
         filename(generateFilename()),
         myid(dash::myid())
     {
         sub_diags = (dash::size() -1) / partests + 1;
-        auto pattern = createPattern();
-        results.allocate(pattern);
+        if(!online) {
+          auto pattern = createPattern(repeats);
+          results.allocate(pattern);
+        } else if(reservoir_size > 0) {
+          reservoirs.allocate(createPattern(reservoir_size));
+        }
 
         // medians pattern
-        dash::Pattern<2> mpat(dash::SizeSpec<2>(dash::size(), dash::size()),
-                              dash::DistributionSpec<2>(dash::BLOCKED, dash::CYCLIC),
-                              dash::TeamSpec<2>(dash::Team::All()));
+        auto mpat = createMatrixPattern();
         medians.allocate(mpat);
         mins.allocate(mpat);
         maxs.allocate(mpat);
+        if(online) {
+          means.allocate(mpat);
+        }
 
         if(myid == 0){
           hostnames.resize(dash::size());
@@ -76,6 +123,52 @@ public:
         }
     }
 
+    /**
+     * Additionally measure every pair with the geometric series of
+     * message sizes min_size, min_size*factor, ... <= max_size bytes
+     * and fit the LogGP parameters. Must be called by all units.
+     */
+    void enableSizeSweep(
+        long min_size,
+        long max_size,
+        int  factor,
+        int  sreps)
+    {
+        sweep         = true;
+        sweep_repeats = sreps;
+        sweep_sizes.clear();
+        for(long size = min_size; size <= max_size; size *= factor){
+          sweep_sizes.push_back(size);
+        }
+
+        sweep_medians.allocate(createPattern(sweep_sizes.size()));
+        loggp.allocate(createPattern(4));
+
+        if(myid == 0){
+          storeSizes();
+        }
+    }
+
+    /**
+     * After the isolated measurement, additionally measure the pairs
+     * of the given patterns all at once: "round" (the rounds of the
+     * tournament), "bisection" (every unit with one in the other half,
+     * first by rank, then in random halves), and "permutation" (random
+     * cycles through all units, only for one-sided kernels). Random
+     * patterns are drawn 'draws' times. Must be called by all units.
+     */
+    void enableContention(
+        const std::vector<std::string> & patterns,
+        int draws)
+    {
+        contention_patterns = patterns;
+        contention_draws    = draws;
+
+        auto mpat = createMatrixPattern();
+        contention_medians.allocate(mpat);
+        degradations.allocate(mpat);
+    }
+
     template<
         typename APKernel>
     void runKernel(APKernel &kernel)
@@ -85,9 +178,7 @@ public:
  
         current_diag = 0;
         int               ndiags   = dash::size();
-        double            measurestart = timer.Now();
         double            kernelstart  = timer.Now();
-        double            elapsed;
         bool              is_inverted = false;
         int               rounds = 2;
 
@@ -98,16 +189,46 @@ public:
                       << "' ==" << std::endl;
         }
 
+        bool do_sweep = sweep && kernel.supportsSizeSweep();
+        if(sweep && !do_sweep && myid == 0) {
+            std::cout << "Kernel '" << kernel.getName()
+                      << "' does not support the size sweep" << std::endl;
+        }
+
         // init kernel
-        kernel.init(repeats);
+        if(do_sweep) {
+            kernel.initSizeSweep(sweep_sizes.front(), sweep_sizes.back());
+            kernel.init(std::max(repeats, sweep_repeats));
+        } else {
+            kernel.init(repeats);
+        }
 
         // clear results
         double no_measure_value = -1;
-        dash::fill(results.begin(), results.end(), no_measure_value);
+        if(!online) {
+            dash::fill(results.begin(), results.end(), no_measure_value);
+        } else {
+            dash::fill(medians.begin(), medians.end(), no_measure_value);
+            dash::fill(mins.begin(), mins.end(), no_measure_value);
+            dash::fill(maxs.begin(), maxs.end(), no_measure_value);
+            dash::fill(means.begin(), means.end(), no_measure_value);
+            if(reservoir_size > 0) {
+                dash::fill(reservoirs.begin(), reservoirs.end(), no_measure_value);
+            }
+        }
+        if(do_sweep) {
+            dash::fill(sweep_medians.begin(), sweep_medians.end(), no_measure_value);
+            dash::fill(loggp.begin(), loggp.end(), no_measure_value);
+        }
 
         if(make_symmetric) {
           rounds = 1;
         }
+        if(tournament) {
+          runTournament(kernel, timer, do_sweep);
+          // skip the diagonals
+          rounds = 0;
+        }
  
         // calculate first pair
         updatePartUnits();
@@ -144,25 +265,7 @@ public:
                   }
                   LOG_UNIT(trace) << "Measure pair " << x << "," << y; 
                   if(!(is_inverted && x == y)) {
-                    // Measure r times
-                    for(int r=0; r<repeats; ++r) {
-                        if(myid == x) {
-                            measurestart = timer.Now();
-                        }
-                        kernel.run(x,y);
-                        if(myid == x) {
-                            int int_repeats = kernel.getInternalRepeats();
-                            elapsed = timer.ElapsedSince(measurestart);
-                            results[x][y][r] = elapsed / int_repeats;
-                            #if VALIDATE_KERNEL
-                            if(!results.at(x,y,r).is_local()){
-                              std::cerr << "Unit " << myid << " index "
-                                        << x << "," << y << "," << r
-                                        << " is not local" << std::endl;
-                            }
-                            #endif
-                        }
-                    }
+                    measurePair(kernel, timer, x, y, do_sweep);
                   }
                 }
                 kernel.reset();
@@ -176,21 +279,41 @@ public:
         }
 
         // Calculate Statistics 
-        calculateStatistics();
+        if(!online) {
+            calculateStatistics();
+        }
+
+        runContention(kernel, timer);
 
         // Store results
         LOG_UNIT(info) << "Store results";
         dio::OutputStream os(this->filename + ".hdf5",
                                  dio::DeviceMode::app);
-        os << dio::dataset(kernel.getName())
-           << results
-           << dio::dataset((kernel.getName() + "_median"))
+        if(!online) {
+            os << dio::dataset(kernel.getName())
+               << results;
+        } else {
+            os << dio::dataset((kernel.getName() + "_mean"))
+               << means;
+            if(reservoir_size > 0) {
+                os << dio::dataset((kernel.getName() + "_reservoir"))
+                   << reservoirs;
+            }
+        }
+        os << dio::dataset((kernel.getName() + "_median"))
            << medians
            << dio::dataset((kernel.getName() + "_min"))
            << mins
            << dio::dataset((kernel.getName() + "_max"))
            << maxs; 
 
+        if(do_sweep) {
+            os << dio::dataset((kernel.getName() + "_sweep_median"))
+               << sweep_medians
+               << dio::dataset((kernel.getName() + "_loggp"))
+               << loggp;
+        }
+
         if(myid == 0) {
             double kernElapsed = timer.ElapsedSince(kernelstart) / 1000000; // Sec
             std::cout << "== done in " << kernElapsed
@@ -217,12 +340,27 @@ private:
         return fname.str();
     }
 
-    const pattern_t createPattern()
+    /**
+     * Pattern of units x units, row x is local to unit x
+     */
+    const dash::Pattern<2> createMatrixPattern()
+    {
+        return dash::Pattern<2>(
+            dash::SizeSpec<2>(dash::size(), dash::size()),
+            dash::DistributionSpec<2>(dash::BLOCKED, dash::CYCLIC),
+            dash::TeamSpec<2>(dash::Team::All()));
+    }
+
+    /**
+     * Pattern of units x units x depth, the values of all pairs
+     * (x,*) are local to unit x
+     */
+    const pattern_t createPattern(int depth)
     {
         // number of units
         int u_size = dash::size();
 
-        dash::SizeSpec<3> sspec(u_size, u_size, this->repeats);
+        dash::SizeSpec<3> sspec(u_size, u_size, depth);
         dash::DistributionSpec<3> dspec(
             dash::BLOCKED,
             dash::CYCLIC,
@@ -233,7 +371,8 @@ private:
     }
 
     /**
-     * Calculate participating units at given k-diagonal
+     * Calculate participating units at given k-diagonal,
+     * the partner of this unit is the one with (x+y) % n == k
      */
     void updatePartUnits()
     {
@@ -242,21 +381,407 @@ private:
 
         LOG_UNIT(debug) << "update participating units";
 
-        for(int y=0; y<n; ++y) {
-            for(int x=0; x<=y; ++x) {
-                if(((x+y) % n) == k) {
-                    if(x == myid || y == myid) {
-                        next_pair.first  = x;
-                        next_pair.second = y;
-                        ++current_diag;
-                        return;
+        if(k < n) {
+            int partner      = (k - myid + n) % n;
+            next_pair.first  = std::min(myid, partner);
+            next_pair.second = std::max(myid, partner);
+        }
+        ++current_diag;
+    }
+
+    /**
+     * Partner of this unit in the given round of a round robin
+     * tournament of n_even units (circle method). Unit n_even-1 stays
+     * fixed, the others rotate. A partner >= dash::size() is a bye.
+     */
+    int tournamentPartner(int round, int n_even)
+    {
+        int m = n_even - 1;
+        if(myid == m) {
+            return round;
+        }
+        int partner = ((2 * round - myid) % m + m) % m;
+        if(partner == myid) {
+            return m;
+        }
+        return partner;
+    }
+
+    /**
+     * Synchronize with the partner only, by an empty message exchange
+     */
+    void syncPair(int partner)
+    {
+        MPI_Sendrecv(nullptr, 0, MPI_BYTE, partner, 97,
+                     nullptr, 0, MPI_BYTE, partner, 97,
+                     MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+    }
+
+    /**
+     * Measure all pairs in n-1 rounds (n rounded up to even) in which
+     * every unit has one partner, computed in O(1). Within a round the
+     * pairs only synchronize with their partner. Both directions of a
+     * pair are measured one after the other, the self pairs in an
+     * additional first round. If the number of simultaneous pairs is
+     * limited, the subrounds are still separated by barriers.
+     */
+    template<
+        typename APKernel>
+    void runTournament(APKernel &kernel, Timer &timer, bool do_sweep)
+    {
+        int n      = dash::size();
+        int n_even = n + (n % 2);
+
+        LOG_UNIT(debug) << "Measure self pair";
+        measurePair(kernel, timer, myid, myid, do_sweep);
+        kernel.reset();
+
+        for(int round = 0; round < n_even - 1; ++round) {
+            int partner = tournamentPartner(round, n_even);
+            int x       = std::min(myid, partner);
+            int y       = std::max(myid, partner);
+
+            LOG_UNIT(debug) << "Measure round " << round
+                            << " out of " << n_even - 1;
+
+            for(int s=0; s<sub_diags; s++){
+              if(sub_diags > 1) {
+                dash::barrier();
+              }
+              if(partner >= n || (x % sub_diags) != s) {
+                continue;
+              }
+              LOG_UNIT(trace) << "Measure pair " << x << "," << y;
+              syncPair(partner);
+              measurePair(kernel, timer, x, y, do_sweep);
+              kernel.reset();
+              if(!make_symmetric) {
+                syncPair(partner);
+                measurePair(kernel, timer, y, x, do_sweep);
+                kernel.reset();
+              }
+            }
+        }
+    }
+
+    /**
+     * Measure all contention patterns and write the medians and the
+     * degradation against the isolated medians for each pattern
+     */
+    template<
+        typename APKernel>
+    void runContention(APKernel &kernel, Timer &timer)
+    {
+        int n = dash::size();
+
+        for(auto & pattern : contention_patterns) {
+            if(pattern == "permutation" && !kernel.isOneSided()) {
+                if(myid == 0) {
+                    std::cout << "Kernel '" << kernel.getName()
+                              << "' needs both units of a pair, skip pattern "
+                              << pattern << std::endl;
+                }
+                continue;
+            }
+            if(pattern != "round" && pattern != "bisection" &&
+               pattern != "permutation") {
+                if(myid == 0) {
+                    std::cout << "unknown contention pattern " << pattern
+                              << std::endl;
+                }
+                continue;
+            }
+
+            LOG_UNIT(info) << "Contention pattern " << pattern;
+
+            double no_measure_value = -1;
+            contention_samples.assign(n, std::vector<double>());
+            dash::fill(contention_medians.begin(), contention_medians.end(),
+                       no_measure_value);
+            dash::fill(degradations.begin(), degradations.end(),
+                       no_measure_value);
+            dash::barrier();
+
+            if(pattern == "round") {
+                int n_even = n + (n % 2);
+                for(int round = 0; round < n_even - 1; ++round) {
+                    int p = tournamentPartner(round, n_even);
+                    measureMatching(kernel, timer, p < n ? p : -1);
+                }
+            } else {
+                for(int d = 0; d < contention_draws; ++d) {
+                    // same order on all units, by rank in the first draw
+                    std::vector<int> order(n);
+                    std::iota(order.begin(), order.end(), 0);
+                    if(d > 0 || pattern == "permutation") {
+                        std::mt19937 rng(d);
+                        std::shuffle(order.begin(), order.end(), rng);
+                    }
+                    int pos = std::find(order.begin(), order.end(), myid)
+                              - order.begin();
+                    if(pattern == "bisection") {
+                        int half = n / 2;
+                        int p    = -1;
+                        if(pos < half) {
+                            p = order[pos + half];
+                        } else if(pos < 2 * half) {
+                            p = order[pos - half];
+                        }
+                        measureMatching(kernel, timer, p);
+                    } else {
+                        // every unit sends to the next one in a random cycle
+                        dash::barrier();
+                        measureRound(kernel, timer, myid,
+                                     order[(pos + 1) % n], n > 1);
                     }
                 }
             }
+
+            // median over all draws and degradation of the pairs of this unit
+            for(int y=0; y<n; ++y){
+              if(!contention_samples[y].empty()){
+                contention_medians.local[0][y] = median(contention_samples[y]);
+              }
+              double contended = contention_medians.local[0][y];
+              double isolated  = medians.local[0][y];
+              if(contended >= 0 && isolated > 0){
+                degradations.local[0][y] = contended / isolated;
+              }
+            }
+
+            dio::OutputStream os(this->filename + ".hdf5",
+                                 dio::DeviceMode::app);
+            os << dio::dataset((kernel.getName() + "_contention_"
+                                + pattern + "_median"))
+               << contention_medians
+               << dio::dataset((kernel.getName() + "_contention_"
+                                + pattern + "_degradation"))
+               << degradations;
         }
-        ++current_diag;
     }
 
+    /**
+     * All units measure with their partner at the same time, or are
+     * idle if partner is -1. One-sided kernels measure both directions
+     * at once, the others one direction after the other.
+     */
+    template<
+        typename APKernel>
+    void measureMatching(APKernel &kernel, Timer &timer, int partner)
+    {
+        bool active = partner >= 0;
+
+        if(kernel.isOneSided()) {
+            dash::barrier();
+            measureRound(kernel, timer, myid, partner, active);
+            return;
+        }
+        int x = std::min(myid, partner);
+        int y = std::max(myid, partner);
+        dash::barrier();
+        measureRound(kernel, timer, x, y, active);
+        dash::barrier();
+        measureRound(kernel, timer, y, x, active);
+    }
+
+    /**
+     * Measure r times from x to y while the other pairs of the
+     * pattern do the same, collect the times in contention_samples
+     */
+    template<
+        typename APKernel>
+    void measureRound(APKernel &kernel, Timer &timer, int x, int y,
+                      bool active)
+    {
+        auto   times = std::vector<double>(repeats);
+        double start = 0;
+
+        if(active) {
+            for(int r=0; r<repeats; ++r) {
+                kernel.prepare(x,y);
+                if(myid == x) {
+                    start = timer.Now();
+                }
+                kernel.run(x,y);
+                if(myid == x) {
+                    times[r] = timer.ElapsedSince(start)
+                               / kernel.getInternalRepeats();
+                }
+            }
+            if(myid == x) {
+                contention_samples[y].insert(contention_samples[y].end(),
+                                             times.begin(), times.end());
+            }
+        }
+        kernel.reset();
+    }
+
+    /**
+     * Measure r times from x to y
+     */
+    template<
+        typename APKernel>
+    void measurePair(APKernel &kernel, Timer &timer, int x, int y,
+                     bool do_sweep)
+    {
+        double measurestart = 0;
+        double elapsed;
+
+        pair_stats.clear();
+        for(int r=0; r<repeats; ++r) {
+            kernel.prepare(x,y);
+            if(myid == x) {
+                measurestart = timer.Now();
+            }
+            kernel.run(x,y);
+            if(myid == x) {
+                int int_repeats = kernel.getInternalRepeats();
+                elapsed = timer.ElapsedSince(measurestart);
+                if(online) {
+                    pair_stats.add(elapsed / int_repeats);
+                    continue;
+                }
+                results[x][y][r] = elapsed / int_repeats;
+                #if VALIDATE_KERNEL
+                if(!results.at(x,y,r).is_local()){
+                  std::cerr << "Unit " << myid << " index "
+                            << x << "," << y << "," << r
+                            << " is not local" << std::endl;
+                }
+                #endif
+            }
+        }
+        if(myid == x && online) {
+            storeOnlineStatistics(x, y);
+        }
+        if(do_sweep) {
+            measureSweep(kernel, timer, x, y);
+        }
+    }
+
+    /**
+     * Store the statistics of the pair (x,y), local to unit x
+     */
+    void storeOnlineStatistics(int x, int y)
+    {
+        medians[x][y] = pair_stats.quantile();
+        mins[x][y]    = pair_stats.min();
+        maxs[x][y]    = pair_stats.max();
+        means[x][y]   = pair_stats.mean();
+
+        auto & sample = pair_stats.sample();
+        for(size_t i=0; i<sample.size(); ++i){
+            reservoirs[x][y][i] = sample[i];
+        }
+    }
+
+  /**
+   * Measure the pair (x,y) for all sizes of the sweep. For the
+   * smallest size, additionally time int_repeats messages issued back
+   * to back, which gives the overhead o and the gap g per message.
+   */
+  template<
+      typename APKernel>
+  void measureSweep(APKernel &kernel, Timer &timer, int x, int y)
+  {
+    int    int_repeats = kernel.getInternalRepeats();
+    auto   times       = std::vector<double>(sweep_repeats);
+    auto   overheads   = std::vector<double>(sweep_repeats);
+    auto   sizemedians = std::vector<double>(sweep_sizes.size());
+    double start       = 0;
+
+    LOG_UNIT(trace) << "Sweep pair " << x << "," << y;
+
+    kernel.setSweeping(true);
+    for(size_t i=0; i<sweep_sizes.size(); ++i){
+      kernel.setMessageSize(sweep_sizes[i]);
+      kernel.reset();
+      for(int r=0; r<sweep_repeats; ++r){
+        kernel.prepare(x,y);
+        if(myid == x){
+          start = timer.Now();
+        }
+        kernel.run(x,y);
+        if(myid == x){
+          times[r] = timer.ElapsedSince(start) / int_repeats;
+        }
+      }
+      if(myid == x){
+        sizemedians[i] = median(times);
+        sweep_medians[x][y][i] = sizemedians[i];
+      }
+    }
+
+    kernel.setMessageSize(sweep_sizes.front());
+    for(int r=0; r<sweep_repeats; ++r){
+      if(myid == x){
+        start = timer.Now();
+      }
+      kernel.issue(x,y);
+      if(myid == x){
+        overheads[r] = timer.ElapsedSince(start) / int_repeats;
+      }
+      kernel.complete(x,y);
+      if(myid == x){
+        times[r] = timer.ElapsedSince(start) / int_repeats;
+      }
+    }
+
+    kernel.setSweeping(false);
+    kernel.setMessageSize(sizeof(int));
+    kernel.reset();
+
+    if(myid == x){
+      auto params = fitLogGP(sizemedians, median(overheads), median(times));
+      for(int p=0; p<4; ++p){
+        loggp[x][y][p] = params[p];
+      }
+    }
+  }
+
+  /**
+   * Fit the LogGP parameters (L, o, g, G) in microseconds and
+   * microseconds per byte to the median time T(s) of a message
+   * of s bytes. T(s) = L + 2o + (s-1)G as in the LogGP model,
+   * with G the least squares slope over the larger half of the
+   * sizes and L from the smallest size.
+   */
+  std::array<double,4> fitLogGP(
+      const std::vector<double> & sizemedians,
+      double o,
+      double g)
+  {
+    size_t n     = sizemedians.size();
+    size_t first = n / 2;
+    double G     = 0;
+
+    if(n - first >= 2){
+      double ms = 0, mt = 0;
+      for(size_t i=first; i<n; ++i){
+        ms += sweep_sizes[i];
+        mt += sizemedians[i];
+      }
+      ms /= (n - first);
+      mt /= (n - first);
+      double sst = 0, ss = 0;
+      for(size_t i=first; i<n; ++i){
+        sst += (sweep_sizes[i] - ms) * (sizemedians[i] - mt);
+        ss  += (sweep_sizes[i] - ms) * (sweep_sizes[i] - ms);
+      }
+      G = std::max(0.0, sst / ss);
+    }
+    double L = std::max(0.0,
+        sizemedians[0] - 2 * o - (sweep_sizes[0] - 1) * G);
+
+    return {{L, o, g, G}};
+  }
+
+  static double median(std::vector<double> values){
+    std::nth_element(values.begin(), values.begin() + values.size() / 2,
+                     values.end());
+    return values[values.size() / 2];
+  }
+
   /**
   * Calculates Min, Max, Median of the measurements
   */
@@ -294,6 +819,18 @@ private:
     }
   }
 
+  void storeSizes(){
+   std::ofstream os(this->filename + "-sizes.csv");
+   // Write Header
+   os << "index;bytes" << std::endl;
+   for(size_t i=0; i<sweep_sizes.size(); ++i){
+      os << i << ";" << sweep_sizes[i];
+      if(i != sweep_sizes.size()-1){
+        os << std::endl;
+      }
+   }
+  }
+
   void storeHostnames(){
    std::ofstream os(this->filename + "-hosts.csv");
    // Write Header
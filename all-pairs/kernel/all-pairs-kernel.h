@@ -2,6 +2,7 @@
 #define ALL_PAIRS_KERNEL_H
 
 #include <string>
+#include <algorithm>
 
 /**
  * AllPairs Kernel concept
@@ -13,6 +14,16 @@ protected:
 const int         int_repeats;
 const int         myid  = 0;
 std::string kernel_name = "Demo";
+/* elements of type int per message, changed by the size sweep */
+long        msg_elems = 1;
+/* buffer elements needed for the largest message of the size sweep */
+long        max_elems = 1;
+/* within the size sweep, all sizes must use the same transfer */
+bool        sweeping  = false;
+
+static long bytesToElems(long bytes){
+  return std::max(1L, bytes / static_cast<long>(sizeof(int)));
+}
 
 AllPairsKernel(int internal_repeats, std::string name)
   : int_repeats(internal_repeats),
@@ -38,6 +49,12 @@ void init(int repeats){}
  */
 void reset(){}
 
+/**
+ * Untimed work before every run(), e.g., to start operations
+ * whose completion run() measures
+ */
+void prepare(int send, int recv){}
+
 /**
  Perform repeated measures on given data point
  */
@@ -54,6 +71,57 @@ const std::string getName(){
 int getInternalRepeats(){
   return this->int_repeats;
 }
+
+/**
+ * True if only the sender takes part in a transfer, so that a unit
+ * can send to one unit while another one sends to it
+ */
+bool isOneSided(){
+  return false;
+}
+
+/**
+ * True if the kernel can transfer messages of arbitrary size
+ * and implements issue() and complete()
+ */
+bool supportsSizeSweep(){
+  return false;
+}
+
+/**
+ * Set the range of message sizes in bytes before init(),
+ * so that the kernel can allocate large enough buffers
+ */
+void initSizeSweep(long min_bytes, long max_bytes){
+  max_elems = std::max(bytesToElems(max_bytes),
+                       int_repeats * bytesToElems(min_bytes));
+}
+
+/**
+ * Tell the kernel that the following runs belong to the size sweep
+ */
+void setSweeping(bool on){
+  sweeping = on;
+}
+
+/**
+ * Set the size of the following messages in bytes
+ */
+void setMessageSize(long bytes){
+  msg_elems = bytesToElems(bytes);
+}
+
+/**
+ * Start int_repeats transfers back to back without waiting
+ * for their completion. Used to measure the overhead o.
+ */
+void issue(int send, int recv){}
+
+/**
+ * Wait for all transfers started by issue(). The time of
+ * issue() and complete() gives the gap g.
+ */
+void complete(int send, int recv){}
 };
 
 
@@ -0,0 +1,42 @@
+#ifndef DASH_ATOMIC_KERNEL_H
+#define DASH_ATOMIC_KERNEL_H
+
+#include <string>
+#include "all-pairs-kernel.h"
+
+/**
+ * Base of the kernels on dash::Atomic, every unit
+ * owns one counter
+ */
+class DashAtomicKernel : public AllPairsKernel {
+
+protected:
+
+typedef dash::Array<dash::Atomic<long>> atomic_array_t;
+
+atomic_array_t counters;
+long           temp;
+
+DashAtomicKernel(int internal_repeats = 1, std::string name = "DASH_ATOMIC")
+  : AllPairsKernel(internal_repeats, name)
+  {}
+
+~DashAtomicKernel(){
+  counters.deallocate();
+  dash::barrier();
+}
+
+public:
+
+void init(int repeats){
+  counters.allocate(dash::size(), dash::BLOCKED);
+  counters[myid].set(0);
+  counters.barrier();
+}
+
+bool isOneSided(){
+  return true;
+}
+};
+
+#endif // DASH_ATOMIC_KERNEL_H
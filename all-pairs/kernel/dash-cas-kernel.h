@@ -0,0 +1,28 @@
+#ifndef DASH_CAS_KERNEL_H
+#define DASH_CAS_KERNEL_H
+
+#include "dash-atomic-kernel.h"
+
+/**
+ * AllPairs kernel for the atomic compare-exchange on the
+ * counter of the receiver. The counters stay zero, so every
+ * exchange succeeds.
+ */
+class DashCASKernel : public DashAtomicKernel {
+
+public:
+
+DashCASKernel(int internal_repeats = 1)
+  : DashAtomicKernel(internal_repeats, "DASH_CAS")
+  {}
+
+void run(int send, int recv){
+  if(myid == send){
+    for(int r=0; r<int_repeats; r++){
+      temp = counters[recv].compare_exchange(0, 0);
+    }
+  }
+}
+};
+
+#endif // DASH_CAS_KERNEL_H
@@ -0,0 +1,31 @@
+#ifndef DASH_COPY_ASYNC_KERNEL_H
+#define DASH_COPY_ASYNC_KERNEL_H
+
+#include "dash-get-kernel.h"
+
+/**
+ * AllPairs kernel for dash::copy_async, every copy is waited
+ * for before the next one is started
+ */
+class DashCopyAsyncKernel : public DashGetKernel {
+
+public:
+
+DashCopyAsyncKernel(int internal_repeats = 1)
+  : DashGetKernel(internal_repeats, "DASH_COPY_ASYNC")
+  {}
+
+void run(int send, int recv){
+      for(int r=0; r<int_repeats; r++){
+        long sr_addr = recv * blocksize + repeat * int_repeats + r;
+        if(myid == send){
+          auto fut = dash::copy_async(testarray.begin() + sr_addr,
+                                      testarray.begin() + sr_addr + msg_elems,
+                                      buffer.data());
+          fut.wait();
+        }
+     }
+     ++repeat;
+}
+};
+#endif  // DASH_COPY_ASYNC_KERNEL_H
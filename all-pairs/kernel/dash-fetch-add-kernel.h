@@ -0,0 +1,27 @@
+#ifndef DASH_FETCH_ADD_KERNEL_H
+#define DASH_FETCH_ADD_KERNEL_H
+
+#include "dash-atomic-kernel.h"
+
+/**
+ * AllPairs kernel for the atomic fetch-add on the
+ * counter of the receiver
+ */
+class DashFetchAddKernel : public DashAtomicKernel {
+
+public:
+
+DashFetchAddKernel(int internal_repeats = 1)
+  : DashAtomicKernel(internal_repeats, "DASH_FETCH_ADD")
+  {}
+
+void run(int send, int recv){
+  if(myid == send){
+    for(int r=0; r<int_repeats; r++){
+      temp = counters[recv].fetch_add(1);
+    }
+  }
+}
+};
+
+#endif // DASH_FETCH_ADD_KERNEL_H
@@ -1,43 +1,70 @@
 #ifndef DASH_GET_KERNEL_H
 #define DASH_GET_KERNEL_H
 
-class DashGetKernel : public AllPairsKernel {
+#include <vector>
+#include "dash-kernel.h"
 
-typedef dash::TilePattern<1>               tpattern_t;
-typedef dash::Array<int, long, tpattern_t> tarray_t;
+class DashGetKernel : public DashKernel {
 
 private:
 
-tarray_t testarray;
-long     blocksize;
 int      temp;
-int      repeat = 0;
+std::vector<dash::Future<int*>>    futures;
+
+protected:
+
+DashGetKernel(int internal_repeats, std::string name)
+  : DashKernel(internal_repeats, name)
+  {}
 
 public:
 
 DashGetKernel(int internal_repeats = 1)
-  : AllPairsKernel(internal_repeats, "DASH_GET")
+  : DashKernel(internal_repeats, "DASH_GET")
   {}
 
-~DashGetKernel(){
-  testarray.deallocate();
-  dash::barrier();
-}
-
-void init(int repeats){
-  blocksize = repeats * int_repeats;
-  long size = dash::size() * blocksize;
-  testarray.allocate(size, dash::BLOCKED);
+bool supportsSizeSweep(){
+  return true;
 }
 
+/**
+ Read from the block of the receiver. Single elements are read
+ with a GlobRef, all messages of the size sweep with dash::copy,
+ also the smallest ones, so that the fit sees one mechanism
+ */
 void run(int send, int recv){
       for(int r=0; r<int_repeats; r++){
-        long sr_addr = send * blocksize + repeat * int_repeats + r;
+        long sr_addr = recv * blocksize + repeat * int_repeats + r;
         if(myid == send){
-          temp = testarray[sr_addr];
+          if(msg_elems == 1 && !sweeping){
+            temp = testarray[sr_addr];
+          } else {
+            dash::copy(testarray.begin() + sr_addr,
+                       testarray.begin() + sr_addr + msg_elems,
+                       buffer.data());
+          }
         }
      }
      ++repeat;
 }
+
+void issue(int send, int recv){
+  if(myid == send){
+    for(int r=0; r<int_repeats; r++){
+      long sr_addr = recv * blocksize + r * msg_elems;
+      futures.push_back(
+        dash::copy_async(testarray.begin() + sr_addr,
+                         testarray.begin() + sr_addr + msg_elems,
+                         buffer.data() + r * msg_elems));
+    }
+  }
+}
+
+void complete(int send, int recv){
+  for(auto & f : futures){
+    f.wait();
+  }
+  futures.clear();
+}
 };
 #endif  // DASH_GET_KERNEL_H
@@ -0,0 +1,53 @@
+#ifndef DASH_KERNEL_H
+#define DASH_KERNEL_H
+
+#include <string>
+#include <vector>
+#include "all-pairs-kernel.h"
+
+/**
+ * Base of the kernels on a blocked dash::Array, every unit
+ * owns a block with room for all measurements of a pair
+ */
+class DashKernel : public AllPairsKernel {
+
+protected:
+
+typedef dash::TilePattern<1>               tpattern_t;
+typedef dash::Array<int, long, tpattern_t> tarray_t;
+
+tarray_t testarray;
+long     blocksize;
+int      repeat = 0;
+/* local source or target of the transfers */
+std::vector<int>                   buffer;
+
+DashKernel(int internal_repeats = 1, std::string name = "DASH")
+  : AllPairsKernel(internal_repeats, name)
+  {}
+
+~DashKernel(){
+  testarray.deallocate();
+  dash::barrier();
+}
+
+public:
+
+void init(int repeats){
+  // room for the largest message of the size sweep at the last address
+  blocksize = repeats * int_repeats + max_elems - 1;
+  long size = dash::size() * blocksize;
+  testarray.allocate(size, dash::BLOCKED);
+  buffer.resize(max_elems);
+}
+
+void reset(){
+  repeat = 0;
+}
+
+bool isOneSided(){
+  return true;
+}
+};
+
+#endif // DASH_KERNEL_H
@@ -0,0 +1,31 @@
+#ifndef DASH_PUT_KERNEL_H
+#define DASH_PUT_KERNEL_H
+
+#include "dash-kernel.h"
+
+/**
+ * AllPairs kernel for single element puts through a GlobRef
+ */
+class DashPutKernel : public DashKernel {
+
+public:
+
+DashPutKernel(int internal_repeats = 1)
+  : DashKernel(internal_repeats, "DASH_PUT")
+  {}
+
+/**
+ Write to the block of the receiver, the assignment
+ returns when the value is written
+ */
+void run(int send, int recv){
+      for(int r=0; r<int_repeats; r++){
+        long sr_addr = recv * blocksize + repeat * int_repeats + r;
+        if(myid == send){
+          testarray[sr_addr] = myid;
+        }
+     }
+     ++repeat;
+}
+};
+#endif  // DASH_PUT_KERNEL_H
@@ -2,6 +2,7 @@
 #define MPI_ASYNC_KERNEL_H 
 
 #include <string>
+#include <vector>
 #include <mpi.h>
 #include "rma-kernel.h"
 
@@ -13,6 +14,7 @@ class MPIASyncKernel : public MPIKernel {
 private:
 MPI_Request    request_send;                                                  
 MPI_Request    request_recv;   
+std::vector<MPI_Request> requests;
 
 public:
 
@@ -27,11 +29,11 @@ void run(int send, int recv){
       for(int r=0; r<int_repeats; r++){
         int sr_addr = repeat * int_repeats + r; // send / recieve addr
         if(myid == send){
-          MPI_Isend (&(send_data[sr_addr]), 1, MPI_INT, recv, 99,    
+          MPI_Isend (&(send_data[sr_addr]), msg_elems, MPI_INT, recv, 99,    
                 MPI_COMM_WORLD, &request_send);                                 
         }
         if(myid == recv){
-          MPI_Irecv (&(recv_data[sr_addr]), 1, MPI_INT, send, 99,    
+          MPI_Irecv (&(recv_data[sr_addr]), msg_elems, MPI_INT, send, 99,    
                 MPI_COMM_WORLD, &request_recv);
           // Wait for request to complete                                   
           MPI_Wait (&request_recv, MPI_STATUS_IGNORE);
@@ -40,6 +42,28 @@ void run(int send, int recv){
       ++repeat;
 }
 
+void issue(int send, int recv){
+      // sends first, then receives, both are posted if send == recv
+      requests.assign(2 * int_repeats, MPI_REQUEST_NULL);
+      for(int r=0; r<int_repeats; r++){
+        int sr_addr = r * msg_elems;
+        if(myid == send){
+          MPI_Isend (&(send_data[sr_addr]), msg_elems, MPI_INT, recv, 98,
+                MPI_COMM_WORLD, &requests[r]);
+        }
+        if(myid == recv){
+          MPI_Irecv (&(recv_data[sr_addr]), msg_elems, MPI_INT, send, 98,
+                MPI_COMM_WORLD, &requests[int_repeats + r]);
+        }
+     }
+}
+
+void complete(int send, int recv){
+      if(myid == send || myid == recv){
+        MPI_Waitall(2 * int_repeats, requests.data(), MPI_STATUSES_IGNORE);
+      }
+}
+
 };
 
 #endif // MPI_ASYNC_KERNEL_H 
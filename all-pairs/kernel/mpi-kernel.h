@@ -26,7 +26,8 @@ MPIKernel(int internal_repeats = 1, std::string name = "MPI")
 
 public:
 void init(int repeats){
-  sr_size = sizeof(int) * repeats * int_repeats;
+  // room for the largest message of the size sweep at the last address
+  sr_size = sizeof(int) * (repeats * int_repeats + max_elems - 1);
   MPI_Alloc_mem(sr_size, MPI_INFO_NULL, &send_data);
   MPI_Alloc_mem(sr_size, MPI_INFO_NULL, &recv_data);
 
@@ -37,5 +38,9 @@ void reset(){
   repeat = 0;
 }
 
+bool supportsSizeSweep(){
+  return true;
+}
+
 };
 #endif // MPI_KERNEL_H
@@ -28,17 +28,37 @@ void run(int send, int recv){
         int sr_addr = repeat * int_repeats + r; // send / recieve addr
         if(myid == send){
             //std::cout << "SENDER: send: " << send << " recv: " << recv << std::endl;
-            MPI_Send (&(send_data[sr_addr]), 1, MPI_INT, recv, 99, MPI_COMM_WORLD);
+            MPI_Send (&(send_data[sr_addr]), msg_elems, MPI_INT, recv, 99, MPI_COMM_WORLD);
         }
         if(myid ==recv){
             //std::cout << "RECEIVER: send: " << send << " recv: " << recv << std::endl;
-            MPI_Recv (&(recv_data[sr_addr]), 1, MPI_INT, send, 99, MPI_COMM_WORLD,
+            MPI_Recv (&(recv_data[sr_addr]), msg_elems, MPI_INT, send, 99, MPI_COMM_WORLD,
                     &status);     
         }
       }
       ++repeat;
 }
 
+/**
+ Blocking sends return only when the buffer can be reused,
+ so the overhead o contains the gap g here
+ */
+void issue(int send, int recv){
+      if(send == recv){
+        return;
+      }
+      for(int r=0; r<int_repeats; r++){
+        int sr_addr = r * msg_elems;
+        if(myid == send){
+            MPI_Send (&(send_data[sr_addr]), msg_elems, MPI_INT, recv, 98, MPI_COMM_WORLD);
+        }
+        if(myid ==recv){
+            MPI_Recv (&(recv_data[sr_addr]), msg_elems, MPI_INT, send, 98, MPI_COMM_WORLD,
+                    &status);
+        }
+      }
+}
+
 };
 
 #endif // MPI_SYNC_KERNEL_H 
@@ -0,0 +1,44 @@
+#ifndef RMA_FLUSH_KERNEL_H
+#define RMA_FLUSH_KERNEL_H
+
+#include <string>
+#include <mpi.h>
+#include "rma-kernel.h"
+
+/**
+ * AllPairs RMA Flush Kernel, measures the flush alone. The put of a
+ * single element is started in prepare(), outside of the timed region,
+ * so that run() times only the MPI_Win_flush that waits for its remote
+ * completion. One flush per measurement, the internal repeats are
+ * always 1.
+ */
+class RMAFlushKernel : public RMAKernel {
+
+public:
+
+    RMAFlushKernel()
+        : RMAKernel(1, "RMA_FLUSH")
+    {}
+
+    void prepare(int send, int recv)
+    {
+        if(dash::myid() == send) {
+            MPI_Put (&(send_data[repeat]), 1, MPI_INT, recv, repeat,
+                     1, MPI_INT, window_recv);
+        }
+    }
+
+    /**
+     Perform repeated measures on given data point
+     */
+    void run(int send, int recv)
+    {
+        if(dash::myid() == send) {
+            MPI_Win_flush(recv, window_recv);
+            ++repeat;
+        }
+    }
+
+};
+
+#endif // RMA_FLUSH_KERNEL_H
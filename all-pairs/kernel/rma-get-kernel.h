@@ -23,14 +23,30 @@ void run(int send, int recv){
   if(dash::myid() == send){
       for(int r=0; r<int_repeats; r++){
         int sr_addr = repeat * int_repeats + r; // send / recieve addr
-        MPI_Get(&(recv_data[sr_addr]), 1, MPI_INT, recv, sr_addr, 1,
-                  MPI_INT, window_send);
+        MPI_Get(&(recv_data[sr_addr]), msg_elems, MPI_INT, recv, sr_addr,
+                  msg_elems, MPI_INT, window_send);
         MPI_Win_flush(recv, window_send);
       }
       ++repeat;
   }
 }
 
+void issue(int send, int recv){
+  if(dash::myid() == send){
+      for(int r=0; r<int_repeats; r++){
+        int sr_addr = r * msg_elems;
+        MPI_Get(&(recv_data[sr_addr]), msg_elems, MPI_INT, recv, sr_addr,
+                  msg_elems, MPI_INT, window_send);
+      }
+  }
+}
+
+void complete(int send, int recv){
+  if(dash::myid() == send){
+    MPI_Win_flush(recv, window_send);
+  }
+}
+
 };
 
 #endif // RMA_GET_KERNEL_H 
@@ -50,6 +50,10 @@ void init(int repeats){
     MPI_Win_lock_all(0, window_recv);
     MPI_Barrier(MPI_COMM_WORLD);
 }
+
+bool isOneSided(){
+  return true;
+}
 };
 
 #endif // RMA_KERNEL_H 
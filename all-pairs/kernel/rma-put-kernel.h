@@ -24,14 +24,32 @@ public:
         if(dash::myid() == send) {
             for(int r=0; r<int_repeats; r++) {
                 int sr_addr = repeat * int_repeats + r; // send / recieve addr
-                MPI_Put (&(send_data[sr_addr]), 1, MPI_INT, recv, sr_addr, 1,
-                         MPI_INT, window_recv);
+                MPI_Put (&(send_data[sr_addr]), msg_elems, MPI_INT, recv, sr_addr,
+                         msg_elems, MPI_INT, window_recv);
                 MPI_Win_flush(recv, window_recv);
             }
             ++repeat;
         }
     }
 
+    void issue(int send, int recv)
+    {
+        if(dash::myid() == send) {
+            for(int r=0; r<int_repeats; r++) {
+                int sr_addr = r * msg_elems;
+                MPI_Put (&(send_data[sr_addr]), msg_elems, MPI_INT, recv, sr_addr,
+                         msg_elems, MPI_INT, window_recv);
+            }
+        }
+    }
+
+    void complete(int send, int recv)
+    {
+        if(dash::myid() == send) {
+            MPI_Win_flush(recv, window_recv);
+        }
+    }
+
 };
 
 #endif // RMA_PUT_KERNEL_H 
@@ -31,6 +31,11 @@
 #include "kernel/mpi-sync-kernel.h"
 #include "kernel/mpi-async-kernel.h"
 #include "kernel/dash-get-kernel.h"
+#include "kernel/dash-put-kernel.h"
+#include "kernel/dash-copy-async-kernel.h"
+#include "kernel/dash-fetch-add-kernel.h"
+#include "kernel/dash-cas-kernel.h"
+#include "kernel/rma-flush-kernel.h"
 
 #include <vector>
 #include <string>
@@ -96,15 +101,49 @@ int main(int argc, char ** argv)
         bool make_sym = opts["make_symmetric"].as<bool>();
         auto kernels  = opts["kernels"].as<kernels_type>();
         int  loglevel = opts["verbose"].as<int>();
+        auto schedule = opts["schedule"].as<std::string>();
+        bool online   = opts["online"].as<bool>();
+        int  reservoir = opts["reservoir"].as<int>();
+        bool sweep    = opts["sweep"].as<bool>();
+        long min_size = opts["min_size"].as<long>();
+        long max_size = opts["max_size"].as<long>();
+        int  sfactor  = opts["size_factor"].as<int>();
+        int  sreps    = opts["sweep_repeats"].as<int>();
+        int  draws    = opts["draws"].as<int>();
+        auto patterns = kernels_type();
+        if(opts.count("contention")) {
+          patterns = opts["contention"].as<kernels_type>();
+        }
 
         // Sanitize
         if((ptests <= 0) || (ptests > dash::size())){
           ptests = dash::size();
         }
+        if(min_size < (long) sizeof(int)){
+          min_size = sizeof(int);
+        }
+        reservoir = std::max(0, std::min(reservoir, repeats));
+        if(sfactor < 2){
+          sfactor = 2;
+        }
+        if(sreps <= 0){
+          sreps = 1;
+        }
+        if(draws <= 0){
+          draws = 1;
+        }
 
         setupLogger(loglevel);
 
-        AllPairs aptest(repeats, ptests, make_sym);
+        AllPairs aptest(repeats, ptests, make_sym, schedule == "tournament",
+                        online, reservoir);
+        if(sweep){
+          aptest.enableSizeSweep(min_size, std::max(min_size, max_size),
+                                 sfactor, sreps);
+        }
+        if(!patterns.empty()){
+          aptest.enableContention(patterns, draws);
+        }
 
         for(auto k:kernels) {
             if(k == "def") {
@@ -125,6 +164,21 @@ int main(int argc, char ** argv)
             } else if(k == "dash_get") {
                 DashGetKernel dash_get(ireps);
                 aptest.runKernel(dash_get);
+            } else if(k == "dash_put") {
+                DashPutKernel dash_put(ireps);
+                aptest.runKernel(dash_put);
+            } else if(k == "dash_copy_async") {
+                DashCopyAsyncKernel dash_copy_async(ireps);
+                aptest.runKernel(dash_copy_async);
+            } else if(k == "dash_fetch_add") {
+                DashFetchAddKernel dash_fetch_add(ireps);
+                aptest.runKernel(dash_fetch_add);
+            } else if(k == "dash_cas") {
+                DashCASKernel dash_cas(ireps);
+                aptest.runKernel(dash_cas);
+            } else if(k == "mpi_rma_flush") {
+                RMAFlushKernel rma_flush;
+                aptest.runKernel(rma_flush);
             } else {
                 std::cout << "unknown kernel" << std::endl;
             }
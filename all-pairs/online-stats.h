@@ -0,0 +1,187 @@
+#ifndef ONLINE_STATS_H
+#define ONLINE_STATS_H
+
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+
+/**
+ * Statistics of a stream of measurements in constant memory:
+ * minimum, maximum, mean, and a quantile estimated with the
+ * P-square algorithm (Jain and Chlamtac, 1985), which keeps five
+ * markers and adjusts their heights with a parabolic formula.
+ * Optionally, a uniform random subsample of the raw values is
+ * kept in a reservoir of fixed size (Vitter's algorithm R).
+ */
+class OnlineStats {
+
+private:
+
+  double              p;
+  long                count;
+  double              min_val;
+  double              max_val;
+  double              mean_val;
+
+  /* P-square markers: heights, positions, desired positions, increments */
+  double              q[5];
+  long                n[5];
+  double              ns[5];
+  double              dn[5];
+
+  std::vector<double> reservoir;
+  size_t              reservoir_size;
+  std::mt19937        rng;
+
+public:
+
+  OnlineStats(
+    double quantile      = 0.5,
+    size_t reservoir_sz  = 0,
+    unsigned int seed    = 0)
+  : p(quantile),
+    reservoir_size(reservoir_sz),
+    rng(seed)
+  {
+    reservoir.reserve(reservoir_size);
+    clear();
+  }
+
+  /**
+   * Forget all values, the random generator continues
+   */
+  void clear(){
+    count    = 0;
+    min_val  = std::numeric_limits<double>::max();
+    max_val  = std::numeric_limits<double>::lowest();
+    mean_val = 0;
+    reservoir.clear();
+  }
+
+  void add(double x){
+    min_val   = std::min(min_val, x);
+    max_val   = std::max(max_val, x);
+    ++count;
+    mean_val += (x - mean_val) / count;
+
+    addToReservoir(x);
+
+    // collect the first five values as initial markers
+    if(count <= 5){
+      q[count - 1] = x;
+      if(count == 5){
+        std::sort(q, q + 5);
+        for(int i=0; i<5; ++i){
+          n[i] = i;
+        }
+        ns[0] = 0;     ns[1] = 2 * p;       ns[2] = 4 * p;
+        ns[3] = 2 + 2 * p;                  ns[4] = 4;
+        dn[0] = 0;     dn[1] = p / 2;       dn[2] = p;
+        dn[3] = (1 + p) / 2;                dn[4] = 1;
+      }
+      return;
+    }
+
+    // cell k with q[k] <= x < q[k+1]
+    int k;
+    if(x < q[0]){
+      q[0] = x;
+      k    = 0;
+    } else if(x >= q[4]){
+      q[4] = x;
+      k    = 3;
+    } else {
+      k = 0;
+      while(x >= q[k+1]){
+        ++k;
+      }
+    }
+    for(int i=k+1; i<5; ++i){
+      ++n[i];
+    }
+    for(int i=0; i<5; ++i){
+      ns[i] += dn[i];
+    }
+
+    // adjust the three middle markers
+    for(int i=1; i<4; ++i){
+      double d = ns[i] - n[i];
+      if((d >=  1 && n[i+1] - n[i] >  1) ||
+         (d <= -1 && n[i-1] - n[i] < -1)){
+        int    s  = (d > 0) ? 1 : -1;
+        double qp = parabolic(i, s);
+        if(q[i-1] < qp && qp < q[i+1]){
+          q[i] = qp;
+        } else {
+          q[i] = q[i] + s * (q[i+s] - q[i]) / (n[i+s] - n[i]);
+        }
+        n[i] += s;
+      }
+    }
+  }
+
+  /**
+   * Estimated quantile, exact for up to five values
+   */
+  double quantile() const {
+    if(count == 0){
+      return 0;
+    }
+    if(count < 5){
+      std::vector<double> first(q, q + count);
+      std::sort(first.begin(), first.end());
+      return first[std::min<long>(count - 1, count * p)];
+    }
+    return q[2];
+  }
+
+  double min() const {
+    return min_val;
+  }
+
+  double max() const {
+    return max_val;
+  }
+
+  double mean() const {
+    return mean_val;
+  }
+
+  long size() const {
+    return count;
+  }
+
+  /**
+   * Uniform random subsample of at most reservoir_sz values
+   */
+  const std::vector<double> & sample() const {
+    return reservoir;
+  }
+
+private:
+
+  double parabolic(int i, int s) const {
+    return q[i] + static_cast<double>(s) / (n[i+1] - n[i-1]) *
+      ((n[i] - n[i-1] + s) * (q[i+1] - q[i]) / (n[i+1] - n[i]) +
+       (n[i+1] - n[i] - s) * (q[i] - q[i-1]) / (n[i] - n[i-1]));
+  }
+
+  void addToReservoir(double x){
+    if(reservoir_size == 0){
+      return;
+    }
+    if(reservoir.size() < reservoir_size){
+      reservoir.push_back(x);
+      return;
+    }
+    std::uniform_int_distribution<long> pos(0, count - 1);
+    long j = pos(rng);
+    if(j < static_cast<long>(reservoir_size)){
+      reservoir[j] = x;
+    }
+  }
+};
+
+#endif // ONLINE_STATS_H
@@ -25,8 +25,24 @@ po::variables_map setup_program_options(int &argc, char ** &argv, bool &valid_op
     ("ptests", po::value<int>()->default_value(0),
               "number of simultaneously tested pairs. Zero if no limit")
     ("kernels", po::value<std::vector<std::string>>()->multitoken(),
-     "kernels to run [def mpi_rma_get mpi_rma_put mpi_sync mpi_async dash_get]")
+     "kernels to run [def mpi_rma_get mpi_rma_put mpi_rma_flush mpi_sync mpi_async "
+     "dash_get dash_put dash_copy_async dash_fetch_add dash_cas]")
     ("make_symmetric", po::value<bool>()->default_value(false), "test only upper half plane")
+    ("contention", po::value<std::vector<std::string>>()->multitoken(),
+     "after the isolated measurement, measure the pairs of these patterns at once [round bisection permutation]")
+    ("draws", po::value<int>()->default_value(4), "number of random bisections and permutations")
+    ("online", po::value<bool>()->default_value(false),
+              "keep only min, max, mean, and an estimated median per pair instead of all measurements")
+    ("reservoir", po::value<int>()->default_value(0),
+              "with online statistics, number of measurements kept as random sample per pair")
+    ("schedule", po::value<std::string>()->default_value("diagonal"),
+              "order of the pairs [diagonal tournament], tournament synchronizes only the pairs")
+    ("sweep", po::value<bool>()->default_value(false),
+              "additionally measure a series of message sizes and fit LogGP parameters")
+    ("min_size", po::value<long>()->default_value(8), "smallest message size of the sweep in bytes")
+    ("max_size", po::value<long>()->default_value(8388608), "largest message size of the sweep in bytes")
+    ("size_factor", po::value<int>()->default_value(4), "factor between two message sizes of the sweep")
+    ("sweep_repeats", po::value<int>()->default_value(10), "number of measurements per pair and message size")
     ("verbose", po::value<int>()->default_value(0), "logging level (0-3), where 0 denotes no logging");
 
   po::variables_map vm;
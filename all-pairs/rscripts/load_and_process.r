@@ -11,8 +11,10 @@ filepath = args[1]
 print(args)
 
 # Get all datasets in this file ending with median or min 
+# (not the medians per message size of the size sweep and not the
+# medians measured under contention)
 filestructure = h5ls(filepath)
-med_sets = filter(filestructure, grepl('median|min', name))
+med_sets = filter(filestructure, grepl('(median|min)$', name) & !grepl('sweep|contention', name))
 
 res     = apply(med_sets, 1, function(name){print(name["name"])})
 
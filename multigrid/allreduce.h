@@ -2,6 +2,9 @@
 #define ALLREDUCE_H
 
 #include <libdash.h>
+#include <mpi.h>
+#include <cassert>
+#include <algorithm>
 
 #ifdef SCOREP_USER_ENABLE
 #include <scorep/SCOREP_User.h>
@@ -15,9 +18,13 @@
 
 Make this a template class with template arguments for the element type
 and for the number of elements per unit.
+
+This is the original version where unit 0 collects all values and sends
+the maximum to every unit, that is O(P) work on unit 0 per reduction.
+Select it with -DUSE_CENTRALIZED_ALLREDUCE.
 */
 
-class Allreduce {
+class AllreduceCentralized {
 
     /* distributed array for all local residual values of every unit.
     It is still going to be allocated in a way, that all elements are
@@ -30,7 +37,7 @@ class Allreduce {
     dash::Array<double> distributed;
 
 public:
-    Allreduce( dash::Team& team ) :
+    AllreduceCentralized( dash::Team& team ) :
       centralized( team.size(), dash::BLOCKCYCLIC(team.size()), team),
       distributed(team.size(), dash::BLOCKED, team) {
         reset(team);
@@ -104,4 +111,258 @@ public:
     }
 };
 
+
+/* Same interface and same semantics as AllreduceCentralized but the maximum is
+reduced and broadcast along a binomial tree over the units of the team, so no
+unit does more than log2(P) puts per reduction.
+
+The tree is rooted at unit 0. The parent of unit r > 0 is r with the lowest
+set bit cleared, its children are r + 2^k for all 2^k below the lowest set
+bit of r (all 2^k < P for the root). A child puts its partial maximum into
+slot k of the parent and then increments the parent's 'up' counter. In the
+same way the parent forwards the result to slot 0 of 'down' of every child
+and increments its 'down' counter. Completion is detected by spinning on the
+own counter only, not by a barrier.
+
+- set() only stores the local value, there is no communication
+- collect_and_spread() does the reduction up the tree (waiting only for the
+  own children), then the root starts the broadcast to its children
+- wait() receives the value from the parent and forwards it to the own
+  children
+
+Unlike the old version there is no barrier, a unit only waits for its
+children and its parent. The signals also order consecutive reductions: a
+child cannot put its next value before it got the result of the previous
+reduction, which the parent only sends after it has read the child's value.
+So callers that need a barrier for other reasons must do it themselves. The
+broadcast overlaps with whatever the caller does between collect_and_spread()
+and wait(), as before.
+
+Like AllreduceCentralized it can be used with a subteam of the team used in
+the constructor, as long as the subteam consists of the first units of it,
+because units are addressed by their id in the subteam. This is asserted in
+every call with a team. */
+
+class AllreduceTree {
+
+    /* number of slots per unit, one for every possible child */
+    size_t nslots;
+
+    /* partial maxima from the children, nslots per unit */
+    dash::Array<double> up;
+
+    /* the global maximum, one per unit */
+    dash::Array<double> down;
+
+    /* number of children that have delivered and whether the parent has */
+    dash::Array<dash::Atomic<int>> upsignal;
+    dash::Array<dash::Atomic<int>> downsignal;
+
+    /* local value from the last set() */
+    double localvalue;
+
+    /* the team of the constructor */
+    dash::Team& base;
+
+    static int lowbit( int r ) { return r & -r; }
+
+    /* calls f( child, k ) for all children of 'me' in a team of 'size' units */
+    template<typename F>
+    static void for_children( int me, int size, F f ) {
+
+        int limit= ( 0 == me ) ? size : lowbit( me );
+        for ( int k= 0; ( 1 << k ) < limit && me + ( 1 << k ) < size; ++k ) {
+            f( me + ( 1 << k ), k );
+        }
+    }
+
+public:
+    AllreduceTree( dash::Team& team ) :
+      nslots( 1 ),
+      up(),
+      down( team.size(), dash::BLOCKED, team ),
+      upsignal( team.size(), team ),
+      downsignal( team.size(), team ),
+      localvalue( std::numeric_limits<double>::max() ),
+      base( team ) {
+
+        while ( ( 1u << nslots ) < team.size() ) ++nslots;
+        up.allocate( team.size() * nslots, dash::BLOCKED, team );
+
+        upsignal[ team.myid() ].set( 0 );
+        downsignal[ team.myid() ].set( 0 );
+        reset( team );
+        team.barrier();
+    }
+
+    /* can be used with a subteam of the team used in the constructor. There
+    must be a barrier before the next collect_and_spread(), as at the start of
+    all smoothers, so that no child puts its value before the slots are reset */
+    void reset( dash::Team& team ) {
+        SCOREP_USER_FUNC()
+        check_subteam( team );
+        std::fill( up.lbegin(), up.lend(), std::numeric_limits<double>::max() );
+        std::fill( down.lbegin(), down.lend(), std::numeric_limits<double>::max() );
+        localvalue= std::numeric_limits<double>::max();
+    }
+
+    /* can be used with a subteam of the team used in the constructor,
+    no barrier */
+    void collect_and_spread( dash::Team& team ) {
+        SCOREP_USER_FUNC()
+        check_subteam( team );
+
+        int me= team.myid();
+        int size= team.size();
+
+        /* wait for all children, then combine */
+        int nchildren= 0;
+        for_children( me, size, [&nchildren]( int, int ) { ++nchildren; } );
+
+        if ( 0 < nchildren ) {
+            auto sig= upsignal[ me ];
+            while ( ! sig.compare_exchange( nchildren, 0 ) ) {};
+        }
+
+        double value= localvalue;
+        for_children( me, size, [&]( int, int k ) {
+            value= std::max( value, up.local[k] );
+        } );
+
+        if ( 0 != me ) {
+
+            int parent= me & ( me - 1 );
+            int k= 0;
+            while ( ( 1 << k ) != me - parent ) ++k;
+
+            up.async[ parent * nslots + k ].set( &value );
+            up.async.flush();
+            upsignal[ parent ].add( 1 );
+            upsignal.flush();
+
+        } else {
+
+            /* the root has the result, start the broadcast */
+            down.local[0]= value;
+            send_down( me, size );
+        }
+    }
+
+    void wait( dash::Team& team ) {
+        SCOREP_USER_FUNC()
+        check_subteam( team );
+
+        int me= team.myid();
+        int size= team.size();
+
+        if ( 0 != me ) {
+
+            auto sig= downsignal[ me ];
+            while ( ! sig.compare_exchange( 1, 0 ) ) {};
+            send_down( me, size );
+        }
+    }
+
+    /* remember the local residual for the next collect_and_spread() by
+    'team', there is no communication */
+    void set( double* res, dash::Team& team ) {
+        SCOREP_USER_FUNC()
+        check_subteam( team );
+        localvalue= *res;
+    }
+
+    double get() const {
+        SCOREP_USER_FUNC()
+        return down.local[0];
+    }
+
+private:
+
+    /* the units are addressed by their id in 'team', which must therefore be the
+    same as in the team of the constructor, i.e., 'team' consists of its first units */
+    void check_subteam( dash::Team& team ) const {
+
+        assert( team.size() <= base.size() );
+        assert( team.myid() == base.myid() );
+        (void) team;
+    }
+
+    void send_down( int me, int size ) {
+
+        bool any= false;
+        for_children( me, size, [&]( int child, int ) {
+            down.async[ child ].set( down.local[0] );
+            any= true;
+        } );
+        if ( any ) {
+            down.async.flush();
+            for_children( me, size, [&]( int child, int ) {
+                downsignal[ child ].add( 1 );
+            } );
+            downsignal.flush();
+        }
+    }
+};
+
+
+/* Non-blocking sum of a few values over all units, for the dot products of the
+conjugate gradient mode. Unlike the classes above it does not take the maximum
+but the sum, and the result is needed right away in the next step instead of one
+iteration later. start() passes the local partial sums to MPI_Iallreduce and
+returns at once, so the reduction overlaps with whatever the caller does until
+finish(), e.g., a halo exchange. Whether it actually progresses in the meantime
+depends on the MPI library, test() gives it a chance to.
+
+Only for dash::Team::All(), which uses MPI_COMM_WORLD. */
+
+class AllreduceSumAsync {
+
+    static const int maxvalues= 4;
+
+    double localvalues[maxvalues];
+    double globalvalues[maxvalues];
+
+    MPI_Request request;
+
+public:
+    AllreduceSumAsync() : request( MPI_REQUEST_NULL ) {}
+
+    ~AllreduceSumAsync() {
+
+        MPI_Wait( &request, MPI_STATUS_IGNORE );
+    }
+
+    void start( const double* values, int n ) {
+        SCOREP_USER_FUNC()
+        assert( n <= maxvalues );
+        assert( MPI_REQUEST_NULL == request );
+
+        std::copy( values, values + n, localvalues );
+        MPI_Iallreduce( localvalues, globalvalues, n, MPI_DOUBLE, MPI_SUM,
+            MPI_COMM_WORLD, &request );
+    }
+
+    /* returns true if the reduction is done */
+    bool test() {
+
+        int flag= 0;
+        MPI_Test( &request, &flag, MPI_STATUS_IGNORE );
+        return flag;
+    }
+
+    /* wait for the sums of the last start() */
+    const double* finish() {
+        SCOREP_USER_FUNC()
+        MPI_Wait( &request, MPI_STATUS_IGNORE );
+        return globalvalues;
+    }
+};
+
+
+#ifdef USE_CENTRALIZED_ALLREDUCE
+typedef AllreduceCentralized Allreduce;
+#else
+typedef AllreduceTree Allreduce;
+#endif
+
 #endif /* ALLREDUCE_H */
@@ -0,0 +1,109 @@
+#ifndef ASYNCWRITER_H
+#define ASYNCWRITER_H
+
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <algorithm>
+
+/* Background writer thread with a bounded queue of jobs, used to overlap
+the formatting and writing of output files with the computation.
+
+push() hands over a job and returns immediately as long as there are
+less than 'capacity' jobs waiting or running. Otherwise it blocks until
+the writer thread has finished one (back-pressure), so the staging
+buffers held by the jobs never exceed 'capacity' output steps. The jobs
+must not do any DASH or MPI calls, only local work and file I/O.
+
+finish() (and the destructor) waits until all jobs are done. */
+
+class AsyncWriter {
+
+    std::deque< std::function< void() > > queue;
+    size_t capacity;
+    /* number of jobs taken from the queue but not finished, 0 or 1 */
+    size_t running;
+    bool done;
+
+    std::mutex mutex;
+    std::condition_variable not_full;
+    std::condition_variable not_empty;
+
+    std::thread worker;
+
+    /* time the producer was blocked because the queue was full */
+    double stalled;
+
+    void run() {
+
+        while ( true ) {
+
+            std::function< void() > job;
+            {
+                std::unique_lock< std::mutex > lock( mutex );
+                not_empty.wait( lock, [this]{ return done || ! queue.empty(); } );
+                if ( queue.empty() ) return;
+
+                job= std::move( queue.front() );
+                queue.pop_front();
+                ++running;
+            }
+
+            job();
+
+            {
+                std::lock_guard< std::mutex > lock( mutex );
+                --running;
+            }
+            not_full.notify_one();
+        }
+    }
+
+public:
+
+    AsyncWriter( size_t _capacity ) :
+        capacity( std::max< size_t >( 1, _capacity ) ), running( 0 ), done( false ), stalled( 0.0 ) {
+
+        worker= std::thread( &AsyncWriter::run, this );
+    }
+
+    ~AsyncWriter() {
+
+        finish();
+    }
+
+    void push( std::function< void() > job ) {
+
+        std::unique_lock< std::mutex > lock( mutex );
+        if ( queue.size() + running >= capacity ) {
+
+            auto start= std::chrono::steady_clock::now();
+            not_full.wait( lock, [this]{ return queue.size() + running < capacity; } );
+            stalled += std::chrono::duration< double >( std::chrono::steady_clock::now() - start ).count();
+        }
+        queue.push_back( std::move( job ) );
+        lock.unlock();
+        not_empty.notify_one();
+    }
+
+    /* wait for all pending jobs and stop the writer thread */
+    void finish() {
+
+        {
+            std::lock_guard< std::mutex > lock( mutex );
+            done= true;
+        }
+        not_empty.notify_one();
+        if ( worker.joinable() ) worker.join();
+    }
+
+    double stalled_seconds() const {
+
+        return stalled;
+    }
+};
+
+#endif /* ASYNCWRITER_H */
@@ -9,6 +9,11 @@
 #include <chrono>
 #include <map>
 #include <tuple>
+#include <cstring>
+#include <string>
+#include <iomanip>
+#include <algorithm>
+#include <memory>
 
 #include <libdash.h>
 
@@ -21,19 +26,39 @@ struct MiniMonValue {
     time_diff_t runtime_min;
     time_diff_t runtime_max;
     uint32_t num;
+    /* summed over all calls */
+    double flops;
+    double bytes;
  //std::numeric_limits<int>::max()
-    MiniMonValue( ) : runtime_sum(0.0), runtime_min(1.0e300), runtime_max(0.0), num(0) {}
+    MiniMonValue( ) : runtime_sum(0.0), runtime_min(1.0e300), runtime_max(0.0), num(0),
+        flops(0.0), bytes(0.0) {}
 
-    void apply( time_diff_t value ) {
+    void apply( time_diff_t value, uint64_t f, uint64_t b ) {
 
         runtime_sum += value;
         runtime_min= std::min( runtime_min, value );
         runtime_max= std::max( runtime_max, value );
         num += 1;
+        flops += f;
+        bytes += b;
     }
 };
 
 
+/* one region of one unit, merged over all entries with the same name and team
+size, to be collected from all units in MiniMon::print_summary() */
+struct MiniMonRecord {
+
+    char name[48];
+    uint32_t par;
+    uint32_t num;
+    double runtime;
+    double flops;
+    double bytes;
+    double stream;
+};
+
+
 static std::ofstream& operator<<(std::ofstream& ofs, const std::vector<std::string>& args) {
   std::string sep = "";
   for (const auto &s : args) {
@@ -55,12 +80,172 @@ public:
       _entries.push(std::chrono::high_resolution_clock::now());
    }
 
-   void stop( const char* n, uint32_t p, uint64_t e = 1,
-         uint64_t f = 0, uint64_t r = 0, uint64_t w = 0 ) {
+   /* p is the team size, e the number of elements of this unit, f the flops,
+   r and w the loads and stores in elements of s bytes. Returns the time of
+   this region in seconds. */
+   double stop( const char* n, uint32_t p, uint64_t e = 1,
+         uint64_t f = 0, uint64_t r = 0, uint64_t w = 0, uint64_t s = sizeof(double) ) {
 
       auto& top = _entries.top();
-      _store[ {n,p,e,f} ].apply( std::chrono::high_resolution_clock::now() - top );
+      time_diff_t t= std::chrono::high_resolution_clock::now() - top;
+      _store[ {n,p,e,f} ].apply( t, f, ( r + w ) * s );
       _entries.pop();
+
+      return t.count();
+   }
+
+   /* Measure the memory bandwidth of this unit in bytes/s with the STREAM triad
+   a= b + s*c over arrays of n doubles, best of 'repeat' runs. All units run it at
+   the same time, so it is the share of this unit of the bandwidth of its node.
+   Counts 24 bytes per element like STREAM. The arrays are first touched by the
+   same threads as in the triad. Must be called by all units. */
+   double measure_stream( size_t n= 1<<22, uint32_t repeat= 5 ) {
+
+      std::unique_ptr<double[]> a( new double[n] );
+      std::unique_ptr<double[]> b( new double[n] );
+      std::unique_ptr<double[]> c( new double[n] );
+      double* pa= a.get();
+      double* pb= b.get();
+      double* pc= c.get();
+#pragma omp parallel for schedule(static)
+      for ( size_t j= 0; j < n; ++j ) {
+         pa[j]= 1.0;
+         pb[j]= 2.0;
+         pc[j]= 0.5;
+      }
+
+      double best= 1.0e300;
+      for ( uint32_t i= 0; i < repeat; ++i ) {
+
+         dash::barrier();
+         auto start= std::chrono::high_resolution_clock::now();
+#pragma omp parallel for schedule(static)
+         for ( size_t j= 0; j < n; ++j ) {
+            pa[j]= pb[j] + 3.0 * pc[j];
+         }
+         time_diff_t t= std::chrono::high_resolution_clock::now() - start;
+         best= std::min( best, t.count() );
+      }
+
+      _stream= 3.0 * sizeof(double) * n / best;
+      return _stream;
+   }
+
+   /* accumulated runtime in seconds of all entries with the given name so far,
+   the difference of two calls gives the time spent in a region in between */
+   double runtime_sum( const char* n ) const {
+
+      double sum= 0.0;
+      for( auto& e : _store) {
+         if ( 0 == strcmp( std::get<0>(e.first), n ) ) {
+            sum += e.second.runtime_sum.count();
+         }
+      }
+      return sum;
+   }
+
+   /* Collect all regions from all units that have them, by name and team size,
+   and write 'overview_summary.csv' with the number of units and calls, the
+   min/avg/max time per unit, the imbalance max/avg -1, the achieved GFLOP/s and
+   GB/s of all units together over the max time, and the fraction of the STREAM
+   bandwidth of these units. A fraction close to 1 means the region is at the
+   memory roofline, a small one with few bytes per call means it is latency bound.
+   Unit 0 also prints the regions that take longest. Must be called by all units
+   before dash::finalize(). */
+   void print_summary( const std::vector<std::string>& tags, size_t lines= 20 ) {
+
+      const size_t max_records= 256;
+      const uint32_t units= dash::Team::All().size();
+
+      /* merge entries with the same name and team size */
+      std::map< std::pair< std::string, uint32_t >, MiniMonRecord > merged;
+      for( auto& e : _store) {
+
+         MiniMonRecord& r= merged[ { std::get<0>(e.first), std::get<1>(e.first) } ];
+         r.par= std::get<1>(e.first);
+         r.num += e.second.num;
+         r.runtime += e.second.runtime_sum.count();
+         r.flops += e.second.flops;
+         r.bytes += e.second.bytes;
+      }
+
+      dash::Array<MiniMonRecord> records( units * max_records );
+      MiniMonRecord* local= records.lbegin();
+      size_t i= 0;
+      for ( auto& m : merged ) {
+
+         if ( max_records <= i ) break;
+         local[i]= m.second;
+         strncpy( local[i].name, m.first.first.c_str(), sizeof(local[i].name) -1 );
+         local[i].name[ sizeof(local[i].name) -1 ]= '\0';
+         local[i].stream= _stream;
+         ++i;
+      }
+      for ( ; i < max_records; ++i ) {
+         local[i]= MiniMonRecord();
+      }
+      records.barrier();
+
+      if ( 0 == dash::myid() ) {
+
+         std::vector<MiniMonRecord> all( units * max_records );
+         dash::copy( records.begin(), records.end(), all.data() );
+
+         struct Summary {
+            uint32_t units= 0;
+            uint64_t num= 0;
+            double min= 1.0e300, max= 0.0, sum= 0.0;
+            double flops= 0.0, bytes= 0.0, stream= 0.0;
+         };
+         std::map< std::pair< std::string, uint32_t >, Summary > summary;
+         for ( auto& r : all ) {
+
+            if ( 0 == r.num ) continue;
+            Summary& s= summary[ { std::string( r.name ), r.par } ];
+            s.units += 1;
+            s.num += r.num;
+            s.min= std::min( s.min, r.runtime );
+            s.max= std::max( s.max, r.runtime );
+            s.sum += r.runtime;
+            s.flops += r.flops;
+            s.bytes += r.bytes;
+            s.stream += r.stream;
+         }
+
+         std::vector< std::pair< std::pair< std::string, uint32_t >, Summary > > sorted( summary.begin(), summary.end() );
+         std::sort( sorted.begin(), sorted.end(), []( const auto& a, const auto& b ) { return a.second.max > b.second.max; } );
+
+         std::ofstream file( "overview_summary.csv" );
+         file << "# tag;function_name;par;units;num_calls;min_runtime;avg_runtime;max_runtime;imbalance;"
+            "gflops_per_s;gbytes_per_s;stream_fraction" << std::endl;
+
+         std::cout << std::endl << "region                       par  units      calls   max time  imbal.  GFLOP/s     GB/s  STREAM" << std::endl;
+         size_t l= 0;
+         for ( auto& e : sorted ) {
+
+            const Summary& s= e.second;
+            double avg= s.sum / s.units;
+            double imbalance= ( 0.0 < avg ) ? s.max / avg - 1.0 : 0.0;
+            double gflops= ( 0.0 < s.max ) ? s.flops / s.max * 1.0e-9 : 0.0;
+            double gbytes= ( 0.0 < s.max ) ? s.bytes / s.max * 1.0e-9 : 0.0;
+            double fraction= ( 0.0 < s.stream ) ? gbytes * 1.0e9 / s.stream : 0.0;
+
+            file << tags << ";" << e.first.first << ";" << e.first.second << ";" << s.units << ";" <<
+               s.num << ";" << s.min << ";" << avg << ";" << s.max << ";" << imbalance << ";" <<
+               gflops << ";" << gbytes << ";" << fraction << std::endl;
+
+            if ( l++ < lines ) {
+               std::cout << std::left << std::setw(28) << e.first.first << std::right <<
+                  std::setw(4) << e.first.second << std::setw(7) << s.units << std::setw(11) << s.num <<
+                  std::fixed << std::setprecision(4) << std::setw(11) << s.max <<
+                  std::setprecision(2) << std::setw(8) << imbalance <<
+                  std::setw(9) << gflops << std::setw(9) << gbytes << std::setw(8) << fraction <<
+                  std::defaultfloat << std::endl;
+            }
+         }
+         file.close();
+      }
+      records.barrier();
    }
 
    void print(uint32_t id, const std::vector<std::string>& tags) {
@@ -72,8 +257,8 @@ public:
       file_name << "overview_" << std::setw(5) << std::setfill('0') << id << ".csv";
       file.open(file_name.str());
 
-      file << "# tag;function_name;par;elements;flops;num_calls;avg_runtime;min_runtime;max_runtime"
-           << std::endl;
+      file << "# tag;function_name;par;elements;flops;num_calls;avg_runtime;min_runtime;max_runtime;"
+           "total_flops;total_bytes" << std::endl;
 
       for( auto& e : _store) {
          file << tags << ";" <<
@@ -84,7 +269,9 @@ public:
             e.second.num << ";" <<
             e.second.runtime_sum.count() / e.second.num << ";" <<
             e.second.runtime_min.count() << ";" <<
-            e.second.runtime_max.count() << std::endl;
+            e.second.runtime_max.count() << ";" <<
+            e.second.flops << ";" <<
+            e.second.bytes << std::endl;
       }
       file.close();
       }
@@ -95,6 +282,8 @@ public:
 private:
    std::map<std::tuple<const char*,uint32_t,uint64_t,uint64_t>,MiniMonValue> _store;
    std::stack<time_point_t, std::vector<time_point_t>> _entries;
+   /* STREAM triad bandwidth of this unit in bytes/s, 0 if not measured */
+   double _stream= 0.0;
 };
 
 #endif /* MINIMONITORING_H */
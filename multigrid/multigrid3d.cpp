@@ -6,10 +6,18 @@
 #include <vector>
 #include <cstdio>
 #include <utility>
+#include <memory>
 #include <math.h>
+#include <fcntl.h>
+#include <cstring>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 #include "allreduce.h"
 #include "minimonitoring.h"
+#include "stencilkernel.h"
 
 #ifdef WITHCSVOUTPUT
 
@@ -18,9 +26,26 @@ even in elastic mode when some units take part in some iterations
 and some do not. Having everyone ++ it individually won't work anymore. */
 dash::Shared<uint32_t>* filenumber;
 
+#include "asyncwriter.h"
+
+/* background writer for the CSV files, NULL for synchronous output */
+AsyncWriter* async_writer= NULL;
+
 
 #endif /* WITHCSVOUTPUT */
 
+#ifdef WITHHDF5OUTPUT
+
+#include <fstream>
+
+namespace dio = dash::io::hdf5;
+
+/* number of the next snapshot file. Snapshots are only written by all
+units together, so every unit can count on its own. */
+uint32_t snapshotnumber= 0;
+
+#endif /* WITHHDF5OUTPUT */
+
 /* TODOs
 
 - add clean version of the code:
@@ -31,6 +56,77 @@ dash::Shared<uint32_t>* filenumber;
 
 MiniMon minimon;
 
+/* depth for temporal blocking in the smoother: the halos are 'blocking_depth'
+layers wide and smoothen() does that many Jacobi sweeps per halo exchange.
+1 means no temporal blocking. */
+uint32_t blocking_depth= 1;
+
+/* cache tiles for the loops over the local blocks in the smoother, scaledown,
+and scaleup, in points in y and x direction. 0 means automatic from the size
+of the L2 cache in 'cache_size' bytes. */
+uint32_t tile_y= 0;
+uint32_t tile_x= 0;
+size_t cache_size= 1<<20;
+
+/* wait for the face halos of the smoother one by one and update the border of
+the local block face by face, see smoothen_faces() */
+bool per_face_halo= false;
+
+/* number of halo exchanges saved by temporal blocking, counted per unit */
+uint64_t halo_exchanges_avoided= 0;
+
+/* the smoother used in the multigrid cycles and the final smoothing */
+enum SmootherKind { JACOBI, REDBLACK, CHEBYSHEV };
+SmootherKind smoother_kind= JACOBI;
+
+/* number of sweeps, i.e., polynomial degree, of the Chebyshev smoother */
+uint32_t chebyshev_degree= 4;
+
+/* cycle schedule of the multigrid modes: gamma recursive calls per level,
+1 gives V-cycles, 2 W-cycles. With cycle_f the recursion does an F-cycle
+followed by a V-cycle on the coarser level instead, that is an F-cycle.
+With use_fmg the iteration starts with a full multigrid pass. */
+uint32_t cycle_gamma= 2;
+bool cycle_f= false;
+bool use_fmg= false;
+
+/* number of Jacobi sweeps before and after the coarse grid correction in the
+V-cycle that is the preconditioner of the MGCG mode */
+uint32_t mgcg_sweeps= 2;
+
+/* damping factor of the Jacobi smoother in the multigrid cycles, and restriction
+with full weighting instead of injection, both only changed by the MGCG mode */
+double jacobi_weight= 1.0;
+bool full_weighting= false;
+
+/* mixed precision multigrid: only the finest level with the solution and the
+outer residual is double, all coarser levels solve for corrections in float */
+bool use_mixed= false;
+
+/* fuse the last pre-smoothing sweep with the restriction and the prolongation with
+the first post-smoothing sweep in the multigrid cycles, only for plain Jacobi */
+bool use_fused= false;
+
+/* write a checkpoint in simulation mode after every 'checkpoint_every' output
+steps, 0 means never. Resume from 'restart_file' if not empty. */
+uint32_t checkpoint_every= 0;
+std::string checkpoint_file= "checkpoint.bin";
+std::string restart_file;
+
+/* time steps in simulation mode: explicit Jacobi steps limited by Level::dt, or
+implicit steps with backward Euler or Crank-Nicolson, solved with the multigrid
+cycles, 'implicit_steps' of them per output interval */
+enum TimeScheme { EXPLICIT, BACKWARD_EULER, CRANK_NICOLSON };
+TimeScheme time_scheme= EXPLICIT;
+uint32_t implicit_steps= 1;
+
+/* progress output and CSV output of all levels in the multigrid cycles, off for
+the many solves of the implicit simulation */
+bool cycle_output= true;
+
+/* measure the STREAM bandwidth at startup for the summary of the minimon regions */
+bool with_stream= false;
+
 using std::cout;
 using std::setfill;
 using std::setw;
@@ -48,9 +144,12 @@ using CycleSpecT = dash::halo::GlobalBoundarySpec<3>;
 using HaloT = dash::halo::HaloMatrixWrapper<MatrixT>;
 using GlobMemT = typename MatrixT::GlobMem_t;
 using StencilOpT = dash::halo::StencilOperator<double,PatternT, GlobMemT,StencilSpecT>;
+using FaceSpecT = dash::halo::StencilSpec<StencilT,6>;
+using FaceOpT = dash::halo::StencilOperator<double,PatternT, GlobMemT,FaceSpecT>;
 
 /* for the smoothing operation, only the 6-point stencil is needed.
-However, the prolongation operation also needs the */
+However, the prolongation operation also needs the edges and corners,
+so this full 26-point version is only used for the halos in scaleup() */
 constexpr StencilSpecT stencil_spec(
     StencilT(0.5, -1, 0, 0), StencilT(0.5, 1, 0, 0),
     StencilT(0.5,  0,-1, 0), StencilT(0.5, 0, 1, 0),
@@ -68,17 +167,153 @@ constexpr StencilSpecT stencil_spec(
     StencilT(0.125, -1, 1,-1), StencilT( 0.125, 1, 1,-1),
     StencilT(0.125, -1, 1, 1), StencilT( 0.125, 1, 1, 1));
 
+/* the 6 face neighbors in the same order as the first 6 points of 'stencil_spec',
+this is all that smoothing, residual, and restriction need. The halo exchange
+for it moves only 6 faces instead of 6 faces, 12 edges, and 8 corners. */
+constexpr FaceSpecT face_spec(
+    StencilT(1.0, -1, 0, 0), StencilT(1.0, 1, 0, 0),
+    StencilT(1.0,  0,-1, 0), StencilT(1.0, 0, 1, 0),
+    StencilT(1.0,  0, 0,-1), StencilT(1.0, 0, 0, 1));
+
+/* same 26 directions as 'stencil_spec' but reaching 'depth' points far. Only used
+to make the halo wrappers 'depth' layers wide for temporal blocking. */
+StencilSpecT deep_stencil_spec( int d ) {
+
+    return StencilSpecT(
+        StencilT(0.5, -d, 0, 0), StencilT(0.5, d, 0, 0),
+        StencilT(0.5,  0,-d, 0), StencilT(0.5, 0, d, 0),
+        StencilT(0.5,  0, 0,-d), StencilT(0.5, 0, 0, d),
+
+        StencilT(0.25, -d,-d, 0), StencilT( 0.25, d, d, 0),
+        StencilT(0.25, -d, 0,-d), StencilT( 0.25, d, 0, d),
+        StencilT(0.25,  0,-d,-d), StencilT( 0.25, 0, d, d),
+        StencilT(0.25, -d, d, 0), StencilT( 0.25, d,-d, 0),
+        StencilT(0.25, -d, 0, d), StencilT( 0.25, d, 0,-d),
+        StencilT(0.25,  0,-d, d), StencilT( 0.25, 0, d,-d),
+
+        StencilT(0.125, -d,-d,-d), StencilT( 0.125, d,-d,-d),
+        StencilT(0.125, -d,-d, d), StencilT( 0.125, d,-d, d),
+        StencilT(0.125, -d, d,-d), StencilT( 0.125, d, d,-d),
+        StencilT(0.125, -d, d, d), StencilT( 0.125, d, d, d));
+}
+
+/* the halo depth that is actually used for a grid of nz×ny×nx distributed by teamspec.
+It is limited by the smallest block of any unit, that is the last one per dimension
+with the BLOCKED distribution. */
+uint32_t halo_depth_for( size_t nz, size_t ny, size_t nx, const TeamSpecT& teamspec ) {
+
+    size_t n[3]= { nz, ny, nx };
+    size_t minblock= n[0];
+    for ( uint32_t d= 0; d < 3; ++d ) {
+
+        size_t units= teamspec.num_units(d);
+        size_t block= ( n[d] + units - 1 ) / units;
+        /* the last unit may get a smaller block or none at all */
+        size_t before= std::min( n[d], ( units - 1 ) * block );
+        minblock= std::min( minblock, n[d] - before );
+    }
+
+    return std::max<size_t>( 1, std::min<size_t>( blocking_depth, minblock ) );
+}
+
+/* tile extents ty×tx for local planes of lh×lw points of 'elemsize' bytes. Automatic
+tiles keep three planes of a tile in half of the cache. They span full rows as long
+as that gives at least 8 rows per tile, otherwise the rows are cut into pieces of a
+multiple of 8 points. */
+void tile_sizes( size_t lh, size_t lw, size_t elemsize, size_t& ty, size_t& tx ) {
+
+    if ( 0 < tile_y && 0 < tile_x ) {
+
+        ty= tile_y;
+        tx= tile_x;
+        return;
+    }
+
+    size_t budget= cache_size / 2 / ( 3 * elemsize );
+    if ( 8 * lw <= budget ) {
+
+        tx= lw;
+    } else {
+
+        tx= std::max<size_t>( 8, budget / 8 / 8 * 8 );
+    }
+    ty= std::max<size_t>( 1, budget / tx );
+}
+
+
+/* the contiguous chunk [kb,ke) of [0,n) of the calling thread in a parallel
+region, like 'schedule(static)' */
+inline void thread_chunk( size_t n, size_t& kb, size_t& ke ) {
+
+#ifdef _OPENMP
+    size_t nt= omp_get_num_threads();
+    size_t t= omp_get_thread_num();
+#else
+    size_t nt= 1;
+    size_t t= 0;
+#endif
+
+    size_t chunk= n / nt;
+    size_t rest= n % nt;
+    kb= t * chunk + std::min( t, rest );
+    ke= kb + chunk + ( ( t < rest ) ? 1 : 0 );
+}
+
+
+/* Call f( z, y, x, n ) for the row pieces [x,x+n) of all rows y and planes z in
+[z0,z1) (with step zstep) × [y0,y1) × [x0,x1), tile by tile. All planes of one
+y-x tile are done before the next tile, so that for every z the planes z-1 and z
+of the tile are still in the cache and only plane z+1 comes from memory.
+
+To be called by all threads of a parallel region. The planes are distributed
+in contiguous chunks over the threads like 'schedule(static)', i.e., the same
+way as in the first touch in initgrid(). */
+template< typename F >
+inline void for_tiles( size_t z0, size_t z1, size_t zstep, size_t y0, size_t y1,
+        size_t x0, size_t x1, size_t ty, size_t tx, F f ) {
+
+    size_t nz= ( z1 > z0 ) ? ( z1 - z0 + zstep - 1 ) / zstep : 0;
+    size_t kb, ke;
+    thread_chunk( nz, kb, ke );
+
+    for ( size_t yt= y0; yt < y1; yt += ty ) {
+        for ( size_t xt= x0; xt < x1; xt += tx ) {
+
+            size_t ye= std::min( yt + ty, y1 );
+            size_t n= std::min( tx, x1 - xt );
+            for ( size_t k= kb; k < ke; ++k ) {
+                for ( size_t y= yt; y < ye; ++y ) {
+
+                    f( z0 + k * zstep, y, xt, n );
+                }
+            }
+        }
+    }
+}
+
 constexpr CycleSpecT cycle_spec(
     dash::halo::BoundaryProp::CUSTOM,
     dash::halo::BoundaryProp::CUSTOM,
     dash::halo::BoundaryProp::CUSTOM );
 
-struct Level {
+/* One grid level of the multigrid hierarchy with element type T. The whole
+code uses Level, i.e., T= double. The coarser levels in mixed precision mode
+use LevelF, i.e., T= float. */
+template< typename T >
+struct LevelT {
 
 public:
   using SizeSpecT = dash::SizeSpec<3>;
   using DistSpecT = dash::DistributionSpec<3>;
 
+  using value_type = T;
+  using MatrixT = dash::NArray<T,3>;
+  using PatternT = typename MatrixT::pattern_type;
+  using HaloT = dash::halo::HaloMatrixWrapper<MatrixT>;
+  using GlobMemT = typename MatrixT::GlobMem_t;
+  using StencilOpT = dash::halo::StencilOperator<T,PatternT, GlobMemT,StencilSpecT>;
+  using FaceOpT = dash::halo::StencilOperator<T,PatternT, GlobMemT,FaceSpecT>;
+
 
     /* now with double-buffering. src_grid and src_halo should only be read,
     newgrid should only be written. dst_grid and dst_halo are only there to keep the other ones
@@ -88,10 +323,21 @@ public:
     MatrixT* src_grid;
     MatrixT* dst_grid;
     MatrixT* rhs_grid; /* right hand side, doesn't need a halo */
+
+    /* Full halos with faces, edges, and corners. Only exchanged for the
+    prolongation in scaleup() and for temporal blocking, src_full_op provides the
+    26-point prolongation stencil. Also used for output and boundary values. */
     HaloT* src_halo;
     HaloT* dst_halo;
-    StencilOpT* src_op;
-    StencilOpT* dst_op;
+    StencilOpT* src_full_op;
+    StencilOpT* dst_full_op;
+
+    /* face-only halos and the 6-point operators for smoothing, residual,
+    and restriction */
+    HaloT* src_face_halo;
+    HaloT* dst_face_halo;
+    FaceOpT* src_op;
+    FaceOpT* dst_op;
 
 
     /* this are the values of the 7 non-zero matrix values -- only 4 different values, though,
@@ -110,52 +356,65 @@ public:
     time simulation mode */
     double dt;
 
+    /* number of halo layers and thus the number of Jacobi sweeps per halo
+    exchange in smoothen(), > 1 only with temporal blocking */
+    uint32_t halo_depth;
+
+    /* right hand side with a halo, only needed for temporal blocking because
+    then the smoother also updates the halo area redundantly. rhs_dirty tells
+    that the rhs_grid was changed since the last update of rhs_halo. */
+    HaloT* rhs_halo;
+    bool rhs_dirty;
+
+    /* step within the Chebyshev polynomial, 0 means restart because src_grid
+    was changed from outside the smoother and dst_grid holds no valid iterate */
+    uint32_t smoother_step;
+
+    /* average time the smoother waited for the halo of each face, in the order
+    z-, z+, y-, y+, x-, x+, only with per_face_halo */
+    double face_wait[6]= { 0.0, 0.0, 0.0, 0.0, 0.0, 0.0 };
+    uint32_t face_order[6]= { 0, 1, 2, 3, 4, 5 };
+
     /*
     lz, ly, lx are the dimensions in meters of the grid including the boundary regions,
     nz, ny, nx are th number of inner grid points per dimension, excluding the boundary regions,
     therefore, lz,ly,lx are discretized into (nz+2)*(ny+2)*(nx+2) grid points
     */
-    Level( double lz, double ly, double lx,
+    LevelT( double lz, double ly, double lx,
            size_t nz, size_t ny, size_t nx,
            dash::Team& team, TeamSpecT teamspec ) :
+        /* in declaration order, the pointers only take the addresses of the members below */
+        src_grid(&_grid_1), dst_grid(&_grid_2), rhs_grid(&_rhs_grid),
+        src_halo(&_halo_grid_1), dst_halo(&_halo_grid_2),
+        src_full_op(&_stencil_op_1),dst_full_op(&_stencil_op_2),
+        src_face_halo(&_face_halo_1), dst_face_halo(&_face_halo_2),
+        src_op(&_face_op_1),dst_op(&_face_op_2),
+        halo_depth( halo_depth_for( nz, ny, nx, teamspec ) ),
+        rhs_halo( NULL ),
+        rhs_dirty( true ),
+        smoother_step( 0 ),
             _grid_1( SizeSpecT( nz, ny, nx ), DistSpecT( dash::BLOCKED, dash::BLOCKED, dash::BLOCKED ), team, teamspec ),
             _grid_2( SizeSpecT( nz, ny, nx ), DistSpecT( dash::BLOCKED, dash::BLOCKED, dash::BLOCKED ), team, teamspec ),
+        _halo_grid_1( _grid_1, cycle_spec, deep_stencil_spec( halo_depth ) ),
+        _halo_grid_2( _grid_2, cycle_spec, deep_stencil_spec( halo_depth ) ),
+        _face_halo_1( _grid_1, cycle_spec, face_spec ),
+        _face_halo_2( _grid_2, cycle_spec, face_spec ),
             _rhs_grid( SizeSpecT( nz, ny, nx ), DistSpecT( dash::BLOCKED, dash::BLOCKED, dash::BLOCKED ), team, teamspec ),
-        _halo_grid_1( _grid_1, cycle_spec, stencil_spec ),
-        _halo_grid_2( _grid_2, cycle_spec, stencil_spec ),
         _stencil_op_1(_halo_grid_1.stencil_operator(stencil_spec)),
         _stencil_op_2(_halo_grid_2.stencil_operator(stencil_spec)),
-        src_grid(&_grid_1), dst_grid(&_grid_2), rhs_grid(&_rhs_grid),
-        src_halo(&_halo_grid_1), dst_halo(&_halo_grid_2),
-        src_op(&_stencil_op_1),dst_op(&_stencil_op_2),
+        _face_op_1(_face_halo_1.stencil_operator(face_spec)),
+        _face_op_2(_face_halo_2.stencil_operator(face_spec)),
         parent(NULL) {
 
         assert( 1 < nz );
         assert( 1 < ny );
         assert( 1 < nx );
 
-        sz= lz;
-        sy= ly;
-        sx= lx;
-
-        double hz= lz/(nz+1);
-        double hy= ly/(ny+1);
-        double hx= lx/(nx+1);
-
-        /* This is the original setting for the linear system. */
-
-        /* stability condition: r <= 1/2 with r= dt/h^2 ==> dt <= 1/2*h^2
-        dtheta= ru*u_plus + ru*u_minus - 2*ru*u_center with ru=dt/hu^2 <= 1/2 */
-        double hmin= std::min( hz, std::min( hy, hx ) );
-        dt= 0.5*hmin*hmin;
-
-        ax= -1.0/hx/hx;
-        ay= -1.0/hy/hy;
-        az= -1.0/hz/hz;
-        acenter= -2.0*(ax+ay+az);
-        m= 1.0 / acenter;
+        if ( 1 < halo_depth ) {
+            rhs_halo= new HaloT( _rhs_grid, cycle_spec, deep_stencil_spec( halo_depth ) );
+        }
 
-        ff= 1.0; /* factor for right-hand-side */
+        set_dimensions( lz, ly, lx );
 
         for ( uint32_t a= 0; a < team.size(); a++ ) {
             if ( a == dash::myid() ) {
@@ -163,7 +422,7 @@ public:
                     cout << "Level " <<
                         "dim. " << lz << "m×" << ly << "m×" << lz << "m " <<
                         "in grid of " << nz << "×" << ny << "×" << nx <<
-                        " h_= " << hz << "," << hy << "," << hx <<
+                        " h_= " << lz/(nz+1) << "," << ly/(ny+1) << "," << lx/(nx+1) <<
                         " with team of " << team.size() <<
                         " ⇒ a_= " << acenter << "," << ax << "," << ay << "," << az <<
                         " , m= " << m << " , ff= " << ff <<endl;
@@ -180,36 +439,42 @@ public:
     grid distances hy, hy, hx.
     nz, ny, nx are th number of inner grid points per dimension, excluding the boundary regions
     */
-    Level( Level& _parent,
+    template< typename P >
+    LevelT( LevelT<P>& _parent,
            size_t nz, size_t ny, size_t nx,
            dash::Team& team, TeamSpecT teamspec ) :
+        /* in declaration order, the pointers only take the addresses of the members below */
+        src_grid(&_grid_1), dst_grid(&_grid_2), rhs_grid(&_rhs_grid),
+        src_halo(&_halo_grid_1), dst_halo(&_halo_grid_2),
+        src_full_op(&_stencil_op_1),dst_full_op(&_stencil_op_2),
+        src_face_halo(&_face_halo_1), dst_face_halo(&_face_halo_2),
+        src_op(&_face_op_1),dst_op(&_face_op_2),
+        halo_depth( halo_depth_for( nz, ny, nx, teamspec ) ),
+        rhs_halo( NULL ),
+        rhs_dirty( true ),
+        smoother_step( 0 ),
             _grid_1( SizeSpecT( nz, ny, nx ), DistSpecT( dash::BLOCKED, dash::BLOCKED, dash::BLOCKED ), team, teamspec ),
             _grid_2( SizeSpecT( nz, ny, nx ), DistSpecT( dash::BLOCKED, dash::BLOCKED, dash::BLOCKED ), team, teamspec ),
+        _halo_grid_1( _grid_1, cycle_spec, deep_stencil_spec( halo_depth ) ),
+        _halo_grid_2( _grid_2, cycle_spec, deep_stencil_spec( halo_depth ) ),
+        _face_halo_1( _grid_1, cycle_spec, face_spec ),
+        _face_halo_2( _grid_2, cycle_spec, face_spec ),
             _rhs_grid( SizeSpecT( nz, ny, nx ), DistSpecT( dash::BLOCKED, dash::BLOCKED, dash::BLOCKED ), team, teamspec ),
-        _halo_grid_1( _grid_1, cycle_spec, stencil_spec ),
-        _halo_grid_2( _grid_2, cycle_spec, stencil_spec ),
         _stencil_op_1(_halo_grid_1.stencil_operator(stencil_spec)),
         _stencil_op_2(_halo_grid_2.stencil_operator(stencil_spec)),
-        src_grid(&_grid_1), dst_grid(&_grid_2), rhs_grid(&_rhs_grid),
-        src_halo(&_halo_grid_1), dst_halo(&_halo_grid_2),
-        src_op(&_stencil_op_1),dst_op(&_stencil_op_2),
-        parent(&_parent) {
+        _face_op_1(_face_halo_1.stencil_operator(face_spec)),
+        _face_op_2(_face_halo_2.stencil_operator(face_spec)),
+        parent( same_level_type( _parent ) ) {
 
         assert( 1 < nz );
         assert( 1 < ny );
         assert( 1 < nx );
 
-        sz= _parent.sz;
-        sy= _parent.sy;
-        sx= _parent.sx;
+        if ( 1 < halo_depth ) {
+            rhs_halo= new HaloT( _rhs_grid, cycle_spec, deep_stencil_spec( halo_depth ) );
+        }
 
-        ax= _parent.ax;
-        ay= _parent.ay;
-        az= _parent.az;
-        acenter= _parent.acenter;
-        ff= _parent.ff;
-        m= _parent.m;
-        dt= _parent.dt;
+        set_parent( _parent );
 
         for ( uint32_t a= 0; a < team.size(); a++ ) {
             if ( a == dash::myid() ) {
@@ -226,16 +491,83 @@ public:
         }
     }
 
-    Level() = delete;
+    LevelT() = delete;
+
+    /* set the physical dimensions and from them the matrix coefficients as for a
+    level without a parent, also used when the level is reused from the LevelPool */
+    void set_dimensions( double lz, double ly, double lx ) {
+
+        sz= lz;
+        sy= ly;
+        sx= lx;
+
+        double hz= lz/(src_grid->extent(0)+1);
+        double hy= ly/(src_grid->extent(1)+1);
+        double hx= lx/(src_grid->extent(2)+1);
+
+        /* This is the original setting for the linear system. */
+
+        /* stability condition: r <= 1/2 with r= dt/h^2 ==> dt <= 1/2*h^2
+        dtheta= ru*u_plus + ru*u_minus - 2*ru*u_center with ru=dt/hu^2 <= 1/2 */
+        double hmin= std::min( hz, std::min( hy, hx ) );
+        dt= 0.5*hmin*hmin;
+
+        ax= -1.0/hx/hx;
+        ay= -1.0/hy/hy;
+        az= -1.0/hz/hz;
+        acenter= -2.0*(ax+ay+az);
+        m= 1.0 / acenter;
+
+        ff= 1.0; /* factor for right-hand-side */
+
+        parent= NULL;
+    }
+
+    /* take the physical dimensions and the matrix coefficients from the parent */
+    template< typename P >
+    void set_parent( LevelT<P>& _parent ) {
+
+        sz= _parent.sz;
+        sy= _parent.sy;
+        sx= _parent.sx;
+
+        ax= _parent.ax;
+        ay= _parent.ay;
+        az= _parent.az;
+        acenter= _parent.acenter;
+        ff= _parent.ff;
+        m= _parent.m;
+        dt= _parent.dt;
+
+        parent= same_level_type( _parent );
+    }
+
+    ~LevelT() {
+
+        delete rhs_halo;
+        rhs_halo= NULL;
+    }
 
     /** swap grid and halos for the double buffering scheme */
     void swap() {
 
         std::swap( src_halo, dst_halo );
         std::swap( src_grid, dst_grid );
+        std::swap( src_full_op, dst_full_op );
+        std::swap( src_face_halo, dst_face_halo );
         std::swap( src_op, dst_op );
     }
 
+    /* set the boundary values for all halos of both grids */
+    template< typename F >
+    void set_custom_halos( F f ) {
+
+        src_halo->set_custom_halos( f );
+        dst_halo->set_custom_halos( f );
+        src_face_halo->set_custom_halos( f );
+        dst_face_halo->set_custom_halos( f );
+    }
+
     /* to be called by the master unit alone */
     void printout() {
 
@@ -459,7 +791,16 @@ public:
         return dt;
     }
 
-    Level* get_parent() {
+    /* change the operator to A + shift*I for the implicit time steps, 0 gives
+    back the original operator */
+    void set_shift( double shift ) {
+
+        acenter= -2.0*(ax+ay+az) + shift;
+        m= 1.0 / acenter;
+    }
+
+    /* NULL if the parent has a different element type */
+    LevelT* get_parent() {
 
         return parent;
     }
@@ -469,13 +810,144 @@ private:
     MatrixT _grid_2;
     HaloT _halo_grid_1;
     HaloT _halo_grid_2;
+    HaloT _face_halo_1;
+    HaloT _face_halo_2;
     MatrixT _rhs_grid;
     StencilOpT _stencil_op_1;
     StencilOpT _stencil_op_2;
+    FaceOpT _face_op_1;
+    FaceOpT _face_op_2;
+
+    LevelT* parent;
+
+    static LevelT* same_level_type( LevelT& p ) { return &p; }
+    template< typename P >
+    static LevelT* same_level_type( LevelT<P>& p ) { return NULL; }
+};
+
+using Level = LevelT<double>;
+using LevelF = LevelT<float>;
+
+
+/**
+Pool of levels to reuse them with their grids, halo wrappers, and stencil
+operators. DASH allocates every grid and halo buffer collectively and registers
+it for RMA, at high unit counts this dominates the setup and fragments the
+registered memory. So instead of deleting a level, give it back with release().
+acquire() returns a released level of the same size on the same team with the
+same distribution and halo depth if there is one, with new dimensions or parent
+coefficients, and only otherwise creates a new one. The grid values and the
+boundary halos are left as they are, initialize them as for a new level.
+
+DASH has no way to place NArrays and halo buffers in a memory segment allocated
+up front, so the pool keeps whole levels instead of sub-allocating from one.
+
+All units of a team must acquire and release the same levels in the same order,
+like with new and delete. clear() deletes all released levels, it must be called
+before dash::finalize().
+*/
+class LevelPool {
+
+    struct Entry {
+
+        Level* level;
+        bool used;
+    };
+
+    vector<Entry> entries;
+
+    /* number of levels created and reused, for the statistics */
+    uint32_t created= 0;
+    uint32_t reused= 0;
+
+    Level* find( size_t nz, size_t ny, size_t nx, dash::Team& team, const TeamSpecT& teamspec ) {
+
+        for ( Entry& e : entries ) {
+
+            const MatrixT& grid= *e.level->src_grid;
+            if ( ! e.used && &grid.team() == &team &&
+                    grid.extent(0) == nz && grid.extent(1) == ny && grid.extent(2) == nx &&
+                    grid.pattern().teamspec().num_units(0) == teamspec.num_units(0) &&
+                    grid.pattern().teamspec().num_units(1) == teamspec.num_units(1) &&
+                    grid.pattern().teamspec().num_units(2) == teamspec.num_units(2) &&
+                    e.level->halo_depth == halo_depth_for( nz, ny, nx, teamspec ) ) {
+
+                e.used= true;
+                e.level->rhs_dirty= true;
+                e.level->smoother_step= 0;
+                std::fill( e.level->face_wait, e.level->face_wait + 6, 0.0 );
+                for ( uint32_t f= 0; f < 6; ++f ) e.level->face_order[f]= f;
+                ++reused;
+                return e.level;
+            }
+        }
 
-    Level* parent;
+        return NULL;
+    }
+
+public:
+
+    Level* acquire( double lz, double ly, double lx,
+            size_t nz, size_t ny, size_t nx, dash::Team& team, TeamSpecT teamspec ) {
+
+        Level* level= find( nz, ny, nx, team, teamspec );
+        if ( NULL != level ) {
+
+            level->set_dimensions( lz, ly, lx );
+            return level;
+        }
+
+        level= new Level( lz, ly, lx, nz, ny, nx, team, teamspec );
+        entries.push_back( { level, true } );
+        ++created;
+        return level;
+    }
+
+    Level* acquire( Level& parent, size_t nz, size_t ny, size_t nx,
+            dash::Team& team, TeamSpecT teamspec ) {
+
+        Level* level= find( nz, ny, nx, team, teamspec );
+        if ( NULL != level ) {
+
+            level->set_parent( parent );
+            return level;
+        }
+
+        level= new Level( parent, nz, ny, nx, team, teamspec );
+        entries.push_back( { level, true } );
+        ++created;
+        return level;
+    }
+
+    /* NULL is ignored, like the dummy entries of the elastic mode */
+    void release( Level* level ) {
+
+        for ( Entry& e : entries ) {
+            if ( e.level == level ) {
+                e.used= false;
+            }
+        }
+    }
+
+    /* delete all released levels */
+    void clear() {
+
+        for ( Entry& e : entries ) {
+            if ( ! e.used ) {
+                delete e.level;
+                e.level= NULL;
+            }
+        }
+        entries.erase( std::remove_if( entries.begin(), entries.end(),
+            []( const Entry& e ) { return NULL == e.level; } ), entries.end() );
+    }
+
+    uint32_t num_created() const { return created; }
+    uint32_t num_reused() const { return reused; }
 };
 
+LevelPool level_pool;
+
 
 /* global resolution for cvs output, should be fixed such that
 paraview gets input of constant dimensions. Any size > 2 should be good
@@ -483,7 +955,9 @@ but odd numbers are suggested. */
 std::array< long int, 3 > resolution= {65,65,65};
 
 /* helper function for the following write_to_cvs() function */
-inline double arbitrary_element( const MatrixT& grid, HaloT& halo,
+template< typename T >
+inline double arbitrary_element( const dash::NArray<T,3>& grid,
+        dash::halo::HaloMatrixWrapper< dash::NArray<T,3> >& halo,
         std::array< long int, 3 >& corner, std::array< size_t, 3 >& localdim,
         int zz, int yy, int xx ) {
 
@@ -517,24 +991,20 @@ Accept checks whether any point is part of the grid or part of the halo to make
 
 */
 //void writeToCsv_interpolate( const Level& level ) {
-void writeToCsv( const Level& level ) {
+template< typename T >
+void writeToCsv( const LevelT<T>& level ) {
 
 #ifdef WITHCSVOUTPUT
 
     using signed_size_t = typename std::make_signed<size_t>::type;
 
-    const MatrixT& grid= *level.src_grid;
-    HaloT& halo= *level.src_halo;
+    const auto& grid= *level.src_grid;
+    auto& halo= *level.src_halo;
 
-    static std::ostringstream csvfile; /* replace ofstream by ostringstream to have
-    only one large file operation -- check if a preallocated C string with snprintf
-    is even faster */
-    csvfile.str(""); /* clear the _static_ ostringstream in case it was used before */
-    std::ofstream csvfileforreal;
     std::ostringstream num_string;
     num_string << std::setw(5) << std::setfill('0') << (uint32_t) filenumber->get();
-    csvfileforreal.open( "image_unit" + std::to_string(grid.team().myid()) +
-        ".csv." + num_string.str() );
+    std::string filename= "image_unit" + std::to_string(grid.team().myid()) +
+        ".csv." + num_string.str();
 
     std::array< long int, 3 > corner= grid.pattern().global( {0,0,0} );
     std::array< size_t, 3 > dim= grid.extents();
@@ -574,6 +1044,11 @@ void writeToCsv( const Level& level ) {
     /* update halo values, cannot do it async here because there is not much else to do. */
     halo.update();
 
+    /* staging buffer with the sampled values of the local part of the output grid,
+    this is all that needs to be done synchronously */
+    std::vector< double > values;
+    values.reserve( ( stop[0]-start[0] ) * ( stop[1]-start[1] ) * ( stop[2]-start[2] ) );
+
     /* z,y,z are in output grid coordinates */
     for ( int z= start[0]; z < stop[0]; ++z ) {
         for ( int y= start[1]; y < stop[1]; ++y ) {
@@ -621,20 +1096,48 @@ void writeToCsv( const Level& level ) {
                 value += factor_b[0]*factor_b[1]*factor_f[2] * arbitrary_element( grid, halo, corner, localdim, pos[0]+add[0], pos[1]+add[1], pos[2]        );
                 value += factor_b[0]*factor_b[1]*factor_b[2] * arbitrary_element( grid, halo, corner, localdim, pos[0]+add[0], pos[1]+add[1], pos[2]+add[2] );
 
-                csvfile <<
-                    setfill('0') << setw(4) << z << "," <<
-                    setfill('0') << setw(4) << y << "," <<
-                    setfill('0') << setw(4) << x << "," <<
-                    (double) level.sz * z / (resolution[0]-1) << "," <<
-                    (double) level.sy * y / (resolution[1]-1) << "," <<
-                    (double) level.sx * x / (resolution[2]-1) << "," <<
-                    value << "\n";
+                values.push_back( value );
             }
         }
     }
 
-    csvfileforreal << csvfile.str();
-    csvfileforreal.close();
+    /* formatting and writing, either in the background writer thread or right here */
+    std::array< long int, 3 > res= resolution;
+    double sz= level.sz, sy= level.sy, sx= level.sx;
+    auto job= [filename,start,stop,res,sz,sy,sx]( const std::vector< double >& values ) {
+
+        std::ostringstream csvfile; /* use ostringstream to have only one large file operation */
+        size_t i= 0;
+        for ( int z= start[0]; z < stop[0]; ++z ) {
+            for ( int y= start[1]; y < stop[1]; ++y ) {
+                for ( int x= start[2]; x < stop[2]; ++x ) {
+
+                    csvfile <<
+                        setfill('0') << setw(4) << z << "," <<
+                        setfill('0') << setw(4) << y << "," <<
+                        setfill('0') << setw(4) << x << "," <<
+                        (double) sz * z / (res[0]-1) << "," <<
+                        (double) sy * y / (res[1]-1) << "," <<
+                        (double) sx * x / (res[2]-1) << "," <<
+                        values[i++] << "\n";
+                }
+            }
+        }
+
+        std::ofstream csvfileforreal( filename );
+        csvfileforreal << csvfile.str();
+        csvfileforreal.close();
+    };
+
+    if ( NULL != async_writer ) {
+
+        /* the job takes over the staging buffer, blocks if too many are pending */
+        auto staged= std::make_shared< std::vector< double > >( std::move( values ) );
+        async_writer->push( [job,staged]() { job( *staged ); } );
+    } else {
+
+        job( values );
+    }
 
 #endif /* WITHCSVOUTPUT */
 }
@@ -695,12 +1198,86 @@ void writeToCsv_full_grid( const Level& level ) {
 }
 
 
-void initgrid( Level& level ) {
+/* Write the inner grid points as one shared binary HDF5 file per call
+'snapshot_<n>.h5' with the parallel HDF5 output of DASH, all units write
+their local blocks at once. Unit 0 adds a small XDMF file 'snapshot_<n>.xmf'
+that describes the grid geometry and the simulation time so that Paraview
+opens the series of snapshots directly. The boundary values are not included.
+Needs to be called by all units of the level's team. */
+void writeSnapshot( const Level& level, double time ) {
+
+#ifdef WITHHDF5OUTPUT
+
+    const MatrixT& grid= *level.src_grid;
+
+    std::ostringstream num_string;
+    num_string << std::setw(5) << std::setfill('0') << snapshotnumber++;
+    std::string name= "snapshot_" + num_string.str();
+
+    {
+        dio::OutputStream os( name + ".h5" );
+        os << dio::dataset( "heat" ) << grid;
+    }
+
+    if ( 0 == grid.team().myid() ) {
+
+        size_t d= grid.extent(0);
+        size_t h= grid.extent(1);
+        size_t w= grid.extent(2);
+
+        /* grid spacing, the inner points start one step from the boundary */
+        double hz= level.sz / ( d + 1 );
+        double hy= level.sy / ( h + 1 );
+        double hx= level.sx / ( w + 1 );
+
+        /* XDMF lists dimensions, origin and spacing with the slowest index first */
+        std::ofstream xmf( name + ".xmf" );
+        xmf << "<?xml version=\"1.0\" ?>\n"
+            "<Xdmf Version=\"2.0\">\n"
+            " <Domain>\n"
+            "  <Grid Name=\"heat\" GridType=\"Uniform\">\n"
+            "   <Time Value=\"" << time << "\"/>\n"
+            "   <Topology TopologyType=\"3DCoRectMesh\" Dimensions=\"" << d << " " << h << " " << w << "\"/>\n"
+            "   <Geometry GeometryType=\"ORIGIN_DXDYDZ\">\n"
+            "    <DataItem Dimensions=\"3\" NumberType=\"Float\" Format=\"XML\">" <<
+                hz << " " << hy << " " << hx << "</DataItem>\n"
+            "    <DataItem Dimensions=\"3\" NumberType=\"Float\" Format=\"XML\">" <<
+                hz << " " << hy << " " << hx << "</DataItem>\n"
+            "   </Geometry>\n"
+            "   <Attribute Name=\"heat\" AttributeType=\"Scalar\" Center=\"Node\">\n"
+            "    <DataItem Dimensions=\"" << d << " " << h << " " << w << "\" NumberType=\"Float\" "
+                "Precision=\"8\" Format=\"HDF\">" << name << ".h5:/heat</DataItem>\n"
+            "   </Attribute>\n"
+            "  </Grid>\n"
+            " </Domain>\n"
+            "</Xdmf>\n";
+        xmf.close();
+    }
+
+#endif /* WITHHDF5OUTPUT */
+}
+
+
+template< typename T >
+void initgrid( LevelT<T>& level ) {
 
     /* not strictly necessary but it also avoids NAN values */
-    dash::fill( level.src_grid->begin(), level.src_grid->end(), 0.0 );
-    dash::fill( level.dst_grid->begin(), level.dst_grid->end(), 0.0 );
-    dash::fill( level.rhs_grid->begin(), level.rhs_grid->end(), 0.0 );
+    /* Fill the local blocks plane by plane with the same static distribution
+    of z-planes to threads as in the smoother. With OpenMP this is the first
+    touch, so every thread's planes end up in its own NUMA domain. */
+    size_t ld= level.src_grid->local.extent(0);
+    size_t plane= level.src_grid->local.extent(1) * level.src_grid->local.extent(2);
+    T* p_src= level.src_grid->lbegin();
+    T* p_dst= level.dst_grid->lbegin();
+    T* p_rhs= level.rhs_grid->lbegin();
+#pragma omp parallel for schedule(static)
+    for ( size_t z= 0; z < ld; z++ ) {
+        std::fill( p_src + z*plane, p_src + (z+1)*plane, T(0) );
+        std::fill( p_dst + z*plane, p_dst + (z+1)*plane, T(0) );
+        std::fill( p_rhs + z*plane, p_rhs + (z+1)*plane, T(0) );
+    }
+    level.rhs_dirty= true;
+    level.smoother_step= 0;
 
     level.src_grid->barrier();
 }
@@ -771,20 +1348,19 @@ void initboundary( Level& level ) {
         return ret;
     };
 
-    level.src_halo->set_custom_halos( lambda );
-    level.dst_halo->set_custom_halos( lambda );
+    level.set_custom_halos( lambda );
 }
 
 
 /* sets all boundary values to 0, that is what is neede on the coarser grids */
-void initboundary_zero( Level& level ) {
+template< typename T >
+void initboundary_zero( LevelT<T>& level ) {
 
     using index_t = dash::default_index_t;
 
     auto lambda= []( const auto& coords ) { return 0.0; };
 
-    level.src_halo->set_custom_halos( lambda );
-    level.dst_halo->set_custom_halos( lambda );
+    level.set_custom_halos( lambda );
 }
 
 
@@ -930,25 +1506,29 @@ void scaledownboundary( Level& fine, Level& coarse ) {
         }
     };
 
-    coarse.src_halo->set_custom_halos( lambda );
-    coarse.dst_halo->set_custom_halos( lambda );
+    coarse.set_custom_halos( lambda );
 }
 
 #define USE_NEW_SCALEUP
 
 #ifdef USE_NEW_SCALEUP
 
-void scaledown( Level& fine, Level& coarse ) {
+/* fine and coarse may have different element types in mixed precision mode,
+the residual is computed in the type of the fine level. With with_inner == false
+only the coarse points on the border of the local block are done, because the
+inner ones were already written by smoothen_restrict(). */
+template< typename TF, typename TC >
+void scaledown( LevelT<TF>& fine, LevelT<TC>& coarse, bool with_inner= true ) {
     using signed_size_t = typename std::make_signed<size_t>::type;
 
     auto& finegrid= *fine.src_grid;
     auto& fine_rhs_grid= *fine.rhs_grid;
     auto& coarsegrid= *coarse.src_grid;
     auto& coarse_rhs_grid= *coarse.rhs_grid;
-    auto& finehalo = *fine.src_halo;
+    auto& finehalo = *fine.src_face_halo;
 
     // stencil points for scale down with coefficients
-    dash::halo::StencilSpec<StencilT,6> stencil_spec(
+    FaceSpecT stencil_spec(
       StencilT(-fine.az, -1, 0, 0), StencilT(-fine.az, 1, 0, 0),
       StencilT(-fine.ay,  0,-1, 0), StencilT(-fine.ay, 0, 1, 0),
       StencilT(-fine.ax,  0, 0,-1), StencilT(-fine.ax, 0, 0, 1)
@@ -992,16 +1572,22 @@ void scaledown( Level& fine, Level& coarse ) {
     /* 1) start async halo exchange for fine grid*/
     finehalo.update_async();
 
-    // iterates over all inner elements and calculates value for coarse rhs grid
-    auto stencil_op_fine = fine.src_halo->stencil_operator(stencil_spec);
-    for ( signed_size_t z= 1; z < extentc[0] - 1 ; z++ ) {
-      for ( signed_size_t y= 1; y < extentc[1] - 1 ; y++ ) {
-        for ( signed_size_t x= 1; x < extentc[2] - 1 ; x++ ) {
+    // iterates over all inner elements and calculates value for coarse rhs grid,
+    // in cache tiles of the fine grid
+    auto stencil_op_fine = fine.src_face_halo->stencil_operator(stencil_spec);
+    if ( with_inner ) {
+    size_t ty, tx;
+    tile_sizes( extentf[1], extentf[2], sizeof(TF), ty, tx );
+#pragma omp parallel
+    for_tiles( 1, extentc[0] - 1, 1, 1, extentc[1] - 1, 1, extentc[2] - 1,
+        std::max<size_t>( 1, ty/2 ), std::max<size_t>( 1, tx/2 ),
+        [&]( signed_size_t z, signed_size_t y, signed_size_t x0, signed_size_t n ) {
+        for ( signed_size_t x= x0; x < x0 + n; x++ ) {
           coarse_rhs_grid.local[z][y][x] = extra_factor * (
               fine.ff * fine_rhs_grid.local[2*z+1][2*y+1][2*x+1] +
               stencil_op_fine.inner.get_value_at({2*z+1,2*y+1,2*x+1}, -fine.acenter));
         }
-      }
+    } );
     }
 
     /* 3) set coarse grid to 0.0 */
@@ -1029,8 +1615,14 @@ void scaledown( Level& fine, Level& coarse ) {
         // default operation std::plus used for stencil point and center values
         stencil_op_fine.boundary.get_value_at(coords_fine, -fine.acenter));
     }
+    coarse.rhs_dirty= true;
+    coarse.smoother_step= 0;
 
-    minimon.stop( "scaledown", finegrid.team().size(), finegrid.local_size() );
+    if ( with_inner ) {
+        minimon.stop( "scaledown", finegrid.team().size(), finegrid.local_size() );
+    } else {
+        minimon.stop( "scaledown_border", finegrid.team().size(), finegrid.local_size() );
+    }
 }
 
 #else
@@ -1204,6 +1796,8 @@ void scaledown( Level& fine, Level& coarse ) {
             }
         }
     }
+    coarse.rhs_dirty= true;
+    coarse.smoother_step= 0;
 
     minimon.stop( "scaledown", par, param );
 }
@@ -1216,11 +1810,12 @@ void scaledown( Level& fine, Level& coarse ) {
 elements. Note that it is 2^n elements per dimension instead of 2^n -1!
 This version loops over the coarse grid */
 //void scaleup_loop_coarse( Level& coarse, Level& fine ) {
-void scaleup( Level& coarse, Level& fine ) {
+template< typename TC, typename TF >
+void scaleup( LevelT<TC>& coarse, LevelT<TF>& fine ) {
     using signed_size_t = typename std::make_signed<size_t>::type;
 
-    MatrixT& coarsegrid= *coarse.src_grid;
-    MatrixT& finegrid= *fine.src_grid;
+    auto& coarsegrid= *coarse.src_grid;
+    auto& finegrid= *fine.src_grid;
 
     // scaleup
     minimon.start();
@@ -1262,15 +1857,23 @@ void scaleup( Level& coarse, Level& fine ) {
 
     /* this is the iterator-ized version of the code */
 
-    auto& stencil_op_fine = *fine.src_op;
+    auto& stencil_op_fine = *fine.src_full_op;
     // set inner elements
-    for ( signed_size_t z= 1; z < extentc[0] - 1; z++ ) {
-      for ( signed_size_t y= 1; y < extentc[1] - 1; y++ ) {
-        for ( signed_size_t x= 1; x < extentc[2] - 1; x++ ) {
+    /* neighboring coarse z-planes both contribute to the fine plane in between,
+    so with threads do all odd and then all even coarse planes. Within every
+    pass go through cache tiles of the fine grid. */
+    size_t ty, tx;
+    tile_sizes( extentf[1], extentf[2], sizeof(TF), ty, tx );
+    for ( signed_size_t z0= 1; z0 <= 2; z0++ ) {
+#pragma omp parallel
+    for_tiles( z0, extentc[0] - 1, 2, 1, extentc[1] - 1, 1, extentc[2] - 1,
+        std::max<size_t>( 1, ty/2 ), std::max<size_t>( 1, tx/2 ),
+        [&]( signed_size_t z, signed_size_t y, signed_size_t x0, signed_size_t n ) {
+        for ( signed_size_t x= x0; x < x0 + n; x++ ) {
           stencil_op_fine.inner.set_values_at({2*z+1, 2*y+1,2*x+1},
           coarsegrid.local[z][y][x], 1.0,std::plus<double>());
         }
-      }
+    } );
     }
 
     // set values for boundary elements, halo elements are excluded
@@ -1310,7 +1913,7 @@ void scaleup( Level& coarse, Level& fine ) {
       for(auto it = region.begin(); it != region_end; ++it) {
         auto coords = it.gcoords();
         // pointer to halo element
-        double* halo_element = coarse.src_halo->halo_element_at_global(coords);
+        TC* halo_element = coarse.src_halo->halo_element_at_global(coords);
 
         // if halo element == nullptr no halo element exists for the given
         // coordinates -> continue with next element
@@ -1350,6 +1953,8 @@ void scaleup( Level& coarse, Level& fine ) {
     coefficient 1.0, 0.5, 0.25, an 0.125 separately. Consider the case where a unit is last in the distributions
     in any dimension, which is marked with 'sub[.]==1'. In those cases change '(extentc[.]-1)' --> '(extentc[.]-1+sub[.])'
     Then sum them up and simplify. */
+    fine.smoother_step= 0;
+
     minimon.stop( "scaleup", coarsegrid.team().size() /* param */, coarsegrid.local_size() /* elem */,
         (2*extentc[0]-1+sub[0])*(2*extentc[1]-1+sub[1])*(2*extentc[2]-1+sub[2])*2 /* flops */ );
 }
@@ -2430,6 +3035,8 @@ void scaleup( Level& coarse, Level& fine ) {
         }
     }
 
+    fine.smoother_step= 0;
+
     minimon.stop( "scaleup", par, param );
 }
 
@@ -2512,143 +3119,203 @@ void scaleup_loop_fine( Level& coarse, Level& fine ) {
     // y-x
     //z-x
 
+    fine.smoother_step= 0;
+
     minimon.stop( "scaleup", par, param );
 }
 
 
-void transfertofewer( Level& source /* with larger team*/, Level& dest /* with smaller team */ ) {
-
-    /* should only be called by the smaller team */
-    assert( 0 == dest.src_grid->team().position() );
-
-    cout << "unit " << dash::myid() << " transfertofewer" << endl;
-
-    /* we need to find the coordinates that the local unit needs to receive
-    from several other units that are not in this team */
-
-    /* we can safely assume that the source blocks are copied entirely */
-
-    std::array< long int, 3 > corner= dest.src_grid->pattern().global( {0,0,0} );
-    std::array< long unsigned int, 3 > sizes= dest.src_grid->pattern().local_extents();
+/* Call f( local offset, global offset, length ) for all runs of elements of the
+local block at 'corner' with extents 'sizes' that are contiguous both in the local
+block and in the canonical global order of a grid with extents 'gext'. 'rblock' are
+the block extents of the grid on the other side of the transfer. A run must also be
+contiguous in the local memory of every unit it touches there, so it never crosses a
+block boundary in x of the other side, and rows (planes) are only merged if both
+blocks span the full width (and height) of the grid, i.e., the teams are split in z
+(and y) only. dash::copy_async() splits such a run into one request per owning unit.  */
+template< typename F >
+void for_transfer_runs( const std::array< long int, 3 >& corner,
+        const std::array< long unsigned int, 3 >& sizes,
+        const std::array< long unsigned int, 3 >& gext,
+        const std::array< long unsigned int, 3 >& rblock, F f ) {
+
+    size_t rowlen= sizes[2];
+    size_t nrows= sizes[1];
+    size_t nplanes= sizes[0];
+    bool merged= false;
+
+    if ( sizes[2] == gext[2] && rblock[2] == gext[2] ) {
+
+        /* rows are adjacent, merge them into planes */
+        rowlen *= sizes[1];
+        nrows= 1;
+        merged= true;
+
+        if ( sizes[1] == gext[1] && rblock[1] == gext[1] ) {
+
+            /* planes are adjacent, too */
+            rowlen *= sizes[0];
+            nplanes= 1;
+        }
+    }
 
-    /*
-    cout << "    start coord: " <<
-        corner[0] << ", "  << corner[1] << ", " << corner[2] << endl;
-    cout << "    extents: " <<
-            sizes[0] << ", "  << sizes[1] << ", " << sizes[2] << endl;
-    cout << "    dest local  dist " << dest.src_grid->lend() - dest.src_grid->lbegin() << endl;
-    cout << "    dest global dist " << dest.src_grid->end() - dest.src_grid->begin() << endl;
-    cout << "    src  local  dist " << source.src_grid->lend() - source.src_grid->lbegin() << endl;
-    cout << "    src  global dist " << source.src_grid->end() - source.src_grid->begin() << endl;
-    */
+    for ( size_t z= 0; z < nplanes; z++ ) {
+        for ( size_t y= 0; y < nrows; y++ ) {
 
-    /* Can I do this any cleverer than loops over the n-1 non-contiguous
-    dimensions and then a dash::copy for the 1 contiguous dimension? */
+            size_t local= ( z * sizes[1] + y ) * sizes[2];
+            size_t global= ( ( corner[0] + z ) * gext[1] + corner[1] + y ) * gext[2] + corner[2];
 
-    /*
-    for ( uint32_t z= 0; z < sizes[0]; z++ ) {
-        for ( uint32_t y= 0; y < sizes[1]; y++ ) {
-            for ( uint32_t x= 0; x < sizes[2]; x++ ) {
+            if ( merged ) {
 
-                (*dest.src_grid)(z,y,x)= (*source.src_grid)(z,y,x);
+                f( local, global, rowlen );
+                continue;
             }
-        }
-    }
-    */
 
-    for ( uint32_t z= 0; z < sizes[0]; z++ ) {
-        for ( uint32_t y= 0; y < sizes[1]; y++ ) {
+            /* cut the row at the block boundaries in x of the other side */
+            size_t x= corner[2];
+            for ( size_t done= 0; done < rowlen; ) {
 
-            size_t offset= ((corner[0]+z)*sizes[1]+y)*sizes[2];
-            std::copy( source.src_grid->begin() + offset, source.src_grid->begin() + offset + sizes[2],
-                &dest.src_grid->local[z][y][0] );
-            std::copy( source.rhs_grid->begin() + offset, source.rhs_grid->begin() + offset + sizes[2],
-                &dest.rhs_grid->local[z][y][0] );
-
-            //dash::copy( start, start + sizes[2], &dest.src_grid->local[z][y][0] );
-            //dash::copy( source.grid.begin()+40, source.grid.begin()+48, buf );
+                size_t len= std::min( rowlen - done, ( x / rblock[2] + 1 ) * rblock[2] - x );
+                f( local + done, global + done, len );
+                x += len;
+                done += len;
+            }
         }
     }
-
 }
 
 
-void transfertomore( Level& source /* with smaller team*/, Level& dest /* with larger team */ ) {
+template< typename T >
+void transfertofewer( LevelT<T>& source /* with larger team*/, LevelT<T>& dest /* with smaller team */ ) {
 
     /* should only be called by the smaller team */
-    assert( 0 == source.src_grid->team().position() );
+    assert( 0 == dest.src_grid->team().position() );
 
-cout << "unit " << dash::myid() << " transfertomore" << endl;
+    // transfertofewer
+    minimon.start();
 
     /* we need to find the coordinates that the local unit needs to receive
     from several other units that are not in this team */
 
-    /* we can safely assume that the source blocks are copied entirely */
+    std::array< long int, 3 > corner= dest.src_grid->pattern().global( {0,0,0} );
+    std::array< long unsigned int, 3 > sizes= dest.src_grid->pattern().local_extents();
+    std::array< long unsigned int, 3 > gext= { dest.src_grid->extent(0),
+        dest.src_grid->extent(1), dest.src_grid->extent(2) };
+    std::array< long unsigned int, 3 > rblock= { source.src_grid->pattern().blocksize(0),
+        source.src_grid->pattern().blocksize(1), source.src_grid->pattern().blocksize(2) };
+
+    /* Get the local block with non-blocking bulk copies of maximal contiguous runs
+    for both grids. All requests are in flight at the same time. */
+    T* p_src= dest.src_grid->lbegin();
+    T* p_rhs= dest.rhs_grid->lbegin();
+    std::vector< dash::Future< T* > > futures;
+    for_transfer_runs( corner, sizes, gext, rblock, [&]( size_t local, size_t global, size_t len ) {
+
+        futures.push_back( dash::copy_async( source.src_grid->begin() + global,
+            source.src_grid->begin() + global + len, p_src + local ) );
+        futures.push_back( dash::copy_async( source.rhs_grid->begin() + global,
+            source.rhs_grid->begin() + global + len, p_rhs + local ) );
+    } );
+
+    for ( auto& f : futures ) f.wait();
+
+    dest.rhs_dirty= true;
+    dest.smoother_step= 0;
+
+    minimon.stop( "transfertofewer", dest.src_grid->team().size(), 2*dest.src_grid->local_size() );
+}
+
+
+template< typename T >
+void transfertomore( LevelT<T>& source /* with smaller team*/, LevelT<T>& dest /* with larger team */ ) {
+
+    /* should only be called by the smaller team */
+    assert( 0 == source.src_grid->team().position() );
+
+    // transfertomore
+    minimon.start();
+
+    /* here the local unit of the smaller team pushes its block to
+    several other units that are not in this team */
 
     std::array< long int, 3 > corner= source.src_grid->pattern().global( {0,0,0} );
     std::array< long unsigned int, 3 > sizes= source.src_grid->pattern().local_extents();
+    std::array< long unsigned int, 3 > gext= { source.src_grid->extent(0),
+        source.src_grid->extent(1), source.src_grid->extent(2) };
+    std::array< long unsigned int, 3 > rblock= { dest.src_grid->pattern().blocksize(0),
+        dest.src_grid->pattern().blocksize(1), dest.src_grid->pattern().blocksize(2) };
 
-    /*
-    cout << "    start coord: " <<
-        corner[0] << ", "  << corner[1] << ", " << corner[2] << endl;
-    cout << "    extents: " <<
-            sizes[0] << ", "  << sizes[1] << ", " << sizes[2] << endl;
-    cout << "    dest local  dist " << source.src_grid->lend() - source.src_grid->lbegin() << endl;
-    cout << "    dest global dist " << source.src_grid->end() - source.src_grid->begin() << endl;
-    cout << "    src  local  dist " << dest.src_grid->lend() - dest.src_grid->lbegin() << endl;
-    cout << "    src  global dist " << dest.src_grid->end() - dest.src_grid->begin() << endl;
-    */
-
-    /* stupid but functional version for the case with only one unit in the smaller team, very slow individual accesses */
-    /*
-    for ( uint32_t z= 0; z < sizes[0]; z++ ) {
-        for ( uint32_t y= 0; y < sizes[1]; y++ ) {
-            for ( uint32_t x= 0; x < sizes[2]; x++ ) {
+    const T* p_src= source.src_grid->lbegin();
+    const T* p_rhs= source.rhs_grid->lbegin();
+    std::vector< dash::Future< typename LevelT<T>::MatrixT::iterator > > futures;
+    for_transfer_runs( corner, sizes, gext, rblock, [&]( size_t local, size_t global, size_t len ) {
 
-                (*dest.src_grid)(z,y,x)= (*source.src_grid)(z,y,x);
-            }
-        }
-    }
-    */
-    for ( uint32_t z= 0; z < sizes[0]; z++ ) {
-        for ( uint32_t y= 0; y < sizes[1]; y++ ) {
+        futures.push_back( dash::copy_async( p_src + local, p_src + local + len,
+            dest.src_grid->begin() + global ) );
+        futures.push_back( dash::copy_async( p_rhs + local, p_rhs + local + len,
+            dest.rhs_grid->begin() + global ) );
+    } );
 
-            size_t offset= ((corner[0]+z)*sizes[1]+y)*sizes[2];
-            std::copy( &source.src_grid->local[z][y][0], &source.src_grid->local[z][y][0] + sizes[2],
-                dest.src_grid->begin() + offset );
-            std::copy( &source.rhs_grid->local[z][y][0], &source.rhs_grid->local[z][y][0] + sizes[2],
-                dest.rhs_grid->begin() + offset );
+    for ( auto& f : futures ) f.wait();
 
-            //dash::copy( start, start + sizes[2], &dest.src_grid->local[z][y][0] );
-            //dash::copy( source.grid.begin()+40, source.grid.begin()+48, buf );
-        }
-    }
+    dest.rhs_dirty= true;
+    dest.smoother_step= 0;
 
-    //std::copy( source.src_grid->begin(), source.src_grid->end(), dest.src_grid->begin() );
+    minimon.stop( "transfertomore", source.src_grid->team().size(), 2*source.src_grid->local_size() );
 }
 
 
 /**
-Smoothen the given level from oldgrid+src_halo to newgrid. Call Level::swap() at the end.
+Temporal blocking version of smoothen(): do 'sweeps' <= level.halo_depth Jacobi sweeps
+with only one halo exchange. The local block plus the halo of depth level.halo_depth is
+copied to a padded buffer. Then every sweep also updates the halo area redundantly,
+with a valid region shrinking by one layer per sweep. The last sweep produces exactly
+the local block, which is copied to dst_grid. Call Level::swap() at the end.
 
-The parallel global residual is returned as a return parameter, but only
-if it is not NULL because then the expensive parallel reduction is just avoided.
+Only the last sweep contributes to the residual.
 */
-double smoothen( Level& level, Allreduce& res, double coeff= 1.0 ) {
+template< typename T >
+double smoothen_blocked( LevelT<T>& level, Allreduce& res, double coeff, uint32_t sweeps ) {
     SCOREP_USER_FUNC()
 
+    using signed_size_t = typename std::make_signed<size_t>::type;
+
+    assert( 0 < sweeps && sweeps <= level.halo_depth );
+
     uint32_t par= level.src_grid->team().size();
 
-    // smoothen
+    // smoothen_blocked
     minimon.start();
 
     level.src_grid->barrier();
 
-    size_t ld= level.src_grid->local.extent(0);
-    size_t lh= level.src_grid->local.extent(1);
-    size_t lw= level.src_grid->local.extent(2);
+    const signed_size_t k= level.halo_depth;
+    const signed_size_t ld= level.src_grid->local.extent(0);
+    const signed_size_t lh= level.src_grid->local.extent(1);
+    const signed_size_t lw= level.src_grid->local.extent(2);
+
+    /* padded extents and strides */
+    const signed_size_t pw= lw + 2*k;
+    const signed_size_t ph= lh + 2*k;
+    const signed_size_t pd= ld + 2*k;
+    const signed_size_t sy= pw;
+    const signed_size_t sz= pw*ph;
+
+    /* buffers are kept across calls, there is only one level at a time in the smoother */
+    static std::vector<T> buf_a;
+    static std::vector<T> buf_b;
+    static std::vector<T> buf_rhs;
+    static const LevelT<T>* rhs_owner= NULL;
+    buf_a.resize( pd*ph*pw );
+    buf_b.resize( pd*ph*pw );
+    buf_rhs.resize( pd*ph*pw );
+
+    auto index= [k,sy,sz]( signed_size_t z, signed_size_t y, signed_size_t x ) {
+        return (z+k)*sz + (y+k)*sy + (x+k);
+    };
 
-    double localres= 0.0;
+    std::array< long int, 3 > corner= level.src_grid->pattern().global( {0,0,0} );
+    std::array< size_t, 3 > dim= level.src_grid->extents();
 
     double ax= level.ax;
     double ay= level.ay;
@@ -2656,105 +3323,157 @@ double smoothen( Level& level, Allreduce& res, double coeff= 1.0 ) {
     double ac= level.acenter;
     double ff= level.ff;
     double m= level.m;
-
     const double c= coeff;
 
-    // async halo update
+    /* calls func(z,y,x) for all local coordinates of the halo shell of width k */
+    auto for_shell= [ld,lh,lw,k]( auto func ) {
+        for ( signed_size_t z= -k; z < ld+k; ++z ) {
+            for ( signed_size_t y= -k; y < lh+k; ++y ) {
+                bool inner_zy= ( 0 <= z && z < ld && 0 <= y && y < lh );
+                for ( signed_size_t x= -k; x < lw+k; ++x ) {
+
+                    if ( inner_zy && 0 <= x && x < lw ) {
+                        /* jump over the local block */
+                        x= lw-1;
+                        continue;
+                    }
+                    func( z, y, x );
+                }
+            }
+        }
+    };
+
     level.src_halo->update_async();
 
-    // smoothen_inner
-    minimon.start();
+    /* the rhs is needed in the halo area, too, but only once after it was changed */
+    if ( level.rhs_dirty || &level != rhs_owner ) {
 
-    // update inner
+        level.rhs_halo->update();
+        const T* rhs= level.rhs_grid->lbegin();
+#pragma omp parallel for schedule(static)
+        for ( signed_size_t z= 0; z < ld; ++z ) {
+            for ( signed_size_t y= 0; y < lh; ++y ) {
+                std::copy( rhs + (z*lh+y)*lw, rhs + (z*lh+y+1)*lw, &buf_rhs[index(z,y,0)] );
+            }
+        }
+        for_shell( [&]( signed_size_t z, signed_size_t y, signed_size_t x ) {
+            buf_rhs[index(z,y,x)]= *level.rhs_halo->halo_element_at_local( {z,y,x} );
+        } );
+        level.rhs_dirty= false;
+        rhs_owner= &level;
+    }
 
-    /* the start value for both, the y loop and the x loop is 1 because either there is
-    a border area next to the halo -- then the first column or row is covered below in
-    the border update -- or there is an outside border -- then the first column or row
-    contains the boundary values. */
-#if 1
-    auto p_rhs=   level.rhs_grid->lbegin();
-    level.src_op->inner.update(level.dst_grid->lbegin(),
-        [&](auto* center, auto* center_dst, auto offset, const auto& offsets) {
-                double dtheta= m * (
-                    ff * p_rhs[offset] -
-                    ax * ( center[offsets[4]] + center[offsets[5]] ) -
-                    ay * ( center[offsets[2]] + center[offsets[3]] ) -
-                    az * ( center[offsets[0]] + center[offsets[1]] ) -
-                    ac * *center );
-                localres= std::max( localres, std::fabs( dtheta ) );
-                *center_dst = *center + c * dtheta;
-        });
-#else
-    auto next_layer_off = lw * lh;
-    auto core_offset = lw * (lh + 1) + 1;
-    for ( size_t z= 1; z < ld-1; z++ ) {
-        for ( size_t y= 1; y < lh-1; y++ ) {
+    /* copy the local block while the halo exchange is in flight */
+    const T* src= level.src_grid->lbegin();
+#pragma omp parallel for schedule(static)
+    for ( signed_size_t z= 0; z < ld; ++z ) {
+        for ( signed_size_t y= 0; y < lh; ++y ) {
+            std::copy( src + (z*lh+y)*lw, src + (z*lh+y+1)*lw, &buf_a[index(z,y,0)] );
+        }
+    }
+
+    level.src_halo->wait();
+
+    /* unit 0 (of any active team) waits until all local residuals from all
+    other active units are in */
+    res.collect_and_spread( level.src_grid->team() );
 
-            /* this should eventually be done with Alpaka or Kokkos to look
-            much nicer but still be fast */
+    /* the halo shell goes to both buffers because the global boundary values
+    in it are never updated but read in every sweep */
+    for_shell( [&]( signed_size_t z, signed_size_t y, signed_size_t x ) {
+        T v= *level.src_halo->halo_element_at_local( {z,y,x} );
+        buf_a[index(z,y,x)]= v;
+        buf_b[index(z,y,x)]= v;
+    } );
 
-            const double* __restrict p_core=  level.src_grid->lbegin() + core_offset;
-            const double* __restrict p_east=  p_core + 1;
-            const double* __restrict p_west=  p_core - 1;
-            const double* __restrict p_north= p_core + lw;
-            const double* __restrict p_south= p_core - lw;
-            const double* __restrict p_up=    p_core + next_layer_off;
-            const double* __restrict p_down=  p_core - next_layer_off;
-            const double* __restrict p_rhs=   level.rhs_grid->lbegin() + core_offset;
-            double* __restrict p_new= level.dst_grid->lbegin() + core_offset;
+    double localres= 0.0;
+    T* from= buf_a.data();
+    T* to= buf_b.data();
+
+    for ( uint32_t s= 1; s <= sweeps; ++s ) {
+
+        /* margin of the valid region around the local block after this sweep,
+        but never update the global boundary */
+        signed_size_t r= sweeps - s;
+        signed_size_t lo[3], hi[3];
+        signed_size_t l[3]= { ld, lh, lw };
+        for ( uint32_t d= 0; d < 3; ++d ) {
+            lo[d]= std::max<signed_size_t>( -r, -corner[d] );
+            hi[d]= std::min<signed_size_t>( l[d]+r, dim[d]-corner[d] );
+        }
 
-            for ( size_t x= 1; x < lw-1; x++ ) {
+#pragma omp parallel for schedule(static) reduction(max:localres)
+        for ( signed_size_t z= lo[0]; z < hi[0]; ++z ) {
+            for ( signed_size_t y= lo[1]; y < hi[1]; ++y ) {
 
-                /*
-                stability condition: r <= 1/2 with r= dt/h^2 ==> dt <= 1/2*h^2
-                dtheta= ru*u_plus + ru*u_minus - 2*ru*u_center with ru=dt/hu^2 <= 1/2
-                */
-                double dtheta= m * (
-                    ff * *p_rhs -
-                    ax * ( *p_east + *p_west ) -
-                    ay * ( *p_north + *p_south ) -
-                    az * ( *p_up + *p_down ) -
-                    ac * *p_core );
-                *p_new= *p_core + c * dtheta;
+                signed_size_t o= index(z,y,lo[2]);
+                const T* __restrict p_core= from + o;
+                const T* __restrict p_rhs= buf_rhs.data() + o;
+                T* __restrict p_new= to + o;
 
-                localres= std::max( localres, std::fabs( dtheta ) );
+                for ( signed_size_t x= 0; x < hi[2]-lo[2]; ++x ) {
+
+                    double dtheta= m * (
+                        ff * p_rhs[x] -
+                        ax * ( p_core[x+1] + p_core[x-1] ) -
+                        ay * ( p_core[x+sy] + p_core[x-sy] ) -
+                        az * ( p_core[x+sz] + p_core[x-sz] ) -
+                        ac * p_core[x] );
+                    p_new[x]= p_core[x] + c * dtheta;
 
-                p_core++;
-                p_east++;
-                p_west++;
-                p_north++;
-                p_south++;
-                p_up++;
-                p_down++;
-                p_rhs++;
-                p_new++;
+                    if ( 0 == r ) {
+                        localres= std::max( localres, std::fabs( dtheta ) );
+                    }
+                }
             }
-            core_offset += lw;
         }
-        core_offset += 2 * lw;
+
+        std::swap( from, to );
     }
-#endif
-    minimon.stop( "smoothen_inner", par, /* elements */ (ld-2)*(lh-2)*(lw-2), /* flops */ 16*(ld-2)*(lh-2)*(lw-2), /*loads*/ 7*(ld-2)*(lh-2)*(lw-2), /* stores */ (ld-2)*(lh-2)*(lw-2) );
 
-    // smoothen_wait
-    minimon.start();
-    // wait for async halo update
+    /* 'from' holds the result of the last sweep */
+    T* dst= level.dst_grid->lbegin();
+#pragma omp parallel for schedule(static)
+    for ( signed_size_t z= 0; z < ld; ++z ) {
+        for ( signed_size_t y= 0; y < lh; ++y ) {
+            std::copy( from + index(z,y,0), from + index(z,y,lw), dst + (z*lh+y)*lw );
+        }
+    }
 
-    level.src_halo->wait();
+    res.wait( level.src_grid->team() );
 
-    minimon.stop( "smoothen_wait", par, /* elements */ ld*lh*lw );
+    /* global residual from former iteration */
+    double oldres= res.get();
 
-    // smoothen_collect
-    minimon.start();
+    res.set( &localres, level.src_grid->team() );
 
-    /* unit 0 (of any active team) waits until all local residuals from all
-    other active units are in */
-    res.collect_and_spread( level.src_grid->team() );
+    level.swap();
 
-    minimon.stop( "smoothen_collect", par );
+    halo_exchanges_avoided += sweeps - 1;
+
+    minimon.stop( "smoothen_blocked", par, /* elements */ ld*lh*lw,
+        /* flops */ 16*ld*lh*lw*sweeps, /*loads*/ 7*ld*lh*lw*sweeps, /* stores */ ld*lh*lw*sweeps, /* bytes per element */ sizeof(T) );
+
+    return oldres;
+}
 
-    // smoothen_outer
-    minimon.start();
+
+/**
+Jacobi update of the points on the border of the local block from src_grid and
+src_face_halo to dst_grid, the halo must be up to date. Returns the local residual
+of these points.
+*/
+template< typename T >
+double smoothen_border( LevelT<T>& level, double c ) {
+
+    double ax= level.ax;
+    double ay= level.ay;
+    double az= level.az;
+    double ac= level.acenter;
+    double ff= level.ff;
+    double m= level.m;
+
+    double localres= 0.0;
 
     /// begin pointer of local block, needed because halo border iterator is read-only
     auto grid_local_begin= level.dst_grid->lbegin();
@@ -2775,224 +3494,1471 @@ double smoothen( Level& level, Allreduce& res, double coeff= 1.0 ) {
         localres= std::max( localres, std::fabs( dtheta ) );
     }
 
-    minimon.stop( "smoothen_outer", par, /* elements */ 2*(ld*lh+lh*lw+lw*ld),
-        /* flops */ 16*(ld*lh+lh*lw+lw*ld), /*loads*/ 7*(ld*lh+lh*lw+lw*ld), /* stores */ (ld*lh+lh*lw+lw*ld) );
+    return localres;
+}
 
-    // smoothen_wait_res
-    minimon.start();
 
-    res.wait( level.src_grid->team() );
+/* region indices of the 6 faces in the halo, (z+1)*9 + (y+1)*3 + (x+1) for the
+directions z-, z+, y-, y+, x-, x+ */
+const dash::halo::region_index_t face_regions[6]= { 4, 22, 10, 16, 12, 14 };
 
-    /* global residual from former iteration */
-    double oldres= res.get();
 
-    res.set( &localres, level.src_grid->team() );
+/**
+Jacobi update of the points of face f of the local block (0 to 5 for z-, z+, y-,
+y+, x-, x+) like smoothen_border(), but only of those that need no other face
+halo than the ones in the bit set 'arrived', which includes f. So the points on
+edges and corners are updated together with the last of their faces, and every
+point exactly once, in whatever order the faces arrive. 'op' is the face stencil
+operator with the coefficients -a of the level. Returns the local residual of
+these points.
+*/
+template< typename T, typename O >
+double smoothen_face( LevelT<T>& level, O& op, double c, uint32_t f, uint32_t arrived ) {
 
-    minimon.stop( "smoothen_wait_res", par );
+    using signed_size_t = typename std::make_signed<size_t>::type;
 
-    level.swap();
+    double ac= level.acenter;
+    double ff= level.ff;
+    double m= level.m;
 
-    minimon.stop( "smoothen", par, /* elements */ ld*lh*lw,
-        /* flops */ 16*ld*lh*lw, /*loads*/ 7*ld*lh*lw, /* stores */ ld*lh*lw );
+    const auto& ext= level.src_grid->local.extents();
+    const T* p_src= level.src_grid->lbegin();
+    const T* p_rhs= level.rhs_grid->lbegin();
+    T* p_dst= level.dst_grid->lbegin();
 
-    return oldres;
-}
+    /* the fixed dimension and the two others */
+    uint32_t d= f / 2;
+    uint32_t d1= ( 0 == d ) ? 1 : 0;
+    uint32_t d2= ( 2 == d ) ? 1 : 2;
 
-//#define DETAILOUTPUT 1
+    double localres= 0.0;
 
-template<typename Iterator>
-void recursive_cycle( Iterator it, Iterator itend,
-        uint32_t beta, uint32_t gamma, double epsilon, Allreduce& res ) {
-    SCOREP_USER_FUNC()
+    std::array< signed_size_t, 3 > coords;
+    coords[d]= ( 0 == f % 2 ) ? 0 : ext[d] - 1;
+    for ( coords[d1]= 0; coords[d1] < (signed_size_t) ext[d1]; ++coords[d1] ) {
+        for ( coords[d2]= 0; coords[d2] < (signed_size_t) ext[d2]; ++coords[d2] ) {
 
-    Iterator itnext( it );
-    ++itnext;
-    /* reached end of recursion? */
-    if ( itend == itnext ) {
+            uint32_t needs= 0;
+            for ( uint32_t e= 0; e < 3; ++e ) {
+                if ( 0 == coords[e] ) needs |= 1 << ( 2*e );
+                if ( (signed_size_t) ext[e] - 1 == coords[e] ) needs |= 1 << ( 2*e + 1 );
+            }
+            if ( 0 != ( needs & ~arrived ) ) continue;
 
-        /* smoothen completely  */
-        uint32_t j= 0;
-        res.reset( (*it)->src_grid->team() );
-        while ( res.get() > epsilon ) {
-            /* need global residual for iteration count */
-            smoothen( **it, res );
+            size_t o= ( coords[0] * ext[1] + coords[1] ) * ext[2] + coords[2];
+            double dtheta= m * ( ff * p_rhs[o] + op.boundary.get_value_at( coords, -ac ) );
+            p_dst[o]= p_src[o] + c * dtheta;
 
-            j++;
-        }
-        if ( 0 == dash::myid()  ) {
-            cout << "smoothing coarsest " << j << " times with residual " << res.get() << endl;
+            localres= std::max( localres, std::fabs( dtheta ) );
         }
-        writeToCsv( **it );
-
-        return;
     }
 
-    /* stepped on the dummy level? ... which is there to signal that it is not
-    the end of the parallel recursion on the coarsest level but a subteam is
-    going on to solve the coarser levels and this unit is not in that subteam.
-    ... sounds complicated, is complicated, change only if you know what you
-    are doing. */
-    if ( NULL == *itnext ) {
+    return localres;
+}
 
-        /* barrier 'Alice', belongs together with the next barrier 'Bob' below */
-        (*it)->src_grid->team().barrier();
 
-        cout << "all meet again here: I'm passive unit " << dash::myid() << endl;
+/**
+Border update of smoothen() with the face halos waited for one by one. DASH can
+wait for a single halo region but not test whether it is complete. So the faces
+are waited for in the order of their average arrival time in the previous
+sweeps, earliest first, and each face is updated as soon as it is there. The
+arrival time is the time from the start of the border update until the wait for
+the face returned, measured with minimon. Unlike the waiting time alone it does
+not depend on how long the faces before it were waited for, and a face only
+moves before another one if it arrived clearly earlier, so the order does not
+oscillate between sweeps. The slowest face comes last, and before it the
+residual reduction of collect_and_spread() is done, so both overlap with the
+tail latency of the slowest neighbor. Returns the local residual of the border.
+*/
+template< typename T >
+double smoothen_faces( LevelT<T>& level, Allreduce& res, double c ) {
 
-        return;
-    }
+    uint32_t par= level.src_grid->team().size();
 
-    /* stepped on a transfer level? */
-    if ( (*it)->src_grid->team().size() != (*itnext)->src_grid->team().size() ) {
+    FaceSpecT spec(
+      StencilT(-level.az, -1, 0, 0), StencilT(-level.az, 1, 0, 0),
+      StencilT(-level.ay,  0,-1, 0), StencilT(-level.ay, 0, 1, 0),
+      StencilT(-level.ax,  0, 0,-1), StencilT(-level.ax, 0, 0, 1)
+    );
+    auto op= level.src_face_halo->stencil_operator( spec );
 
-        /* only the members of the reduced team need to work, all others do siesta. */
-        //if ( 0 == (*itnext)->grid.team().position() )
-        assert( 0 == (*itnext)->src_grid->team().position() );
-        {
+    uint32_t* order= level.face_order;
 
-            cout << "transfer to " <<
-                (*it)->src_grid->extent(2) << "×" <<
-                (*it)->src_grid->extent(1) << "×" <<
-                (*it)->src_grid->extent(0) << " with " << (*it)->src_grid->team().size() << " units "
-                " ⇒ " <<
-                (*itnext)->src_grid->extent(2) << "×" <<
-                (*itnext)->src_grid->extent(1) << "×" <<
-                (*itnext)->src_grid->extent(0) << " with " << (*itnext)->src_grid->team().size() << " units " << endl;
+    const auto& ext= level.src_grid->local.extents();
+    double localres= 0.0;
+    uint32_t arrived= 0;
+    double elapsed= 0.0;
+    for ( uint32_t k= 0; k < 6; ++k ) {
 
-            transfertofewer( **it, **itnext );
+        uint32_t f= order[k];
 
-            /* don't apply a gamma != 1 here! */
-            recursive_cycle( itnext, itend, beta, gamma, epsilon, res );
+        if ( 5 == k ) {
 
-            cout << "transfer back " <<
-            (*itnext)->src_grid->extent(2) << "×" <<
-            (*itnext)->src_grid->extent(1) << "×" <<
-            (*itnext)->src_grid->extent(0) << " with " << (*itnext)->src_grid->team().size() << " units "
-            " ⇒ " <<
-            (*it)->src_grid->extent(2) << "×" <<
-            (*it)->src_grid->extent(1) << "×" <<
-            (*it)->src_grid->extent(0) << " with " << (*it)->src_grid->team().size() << " units " <<  endl;
+            // smoothen_collect
+            minimon.start();
 
-            transfertomore( **itnext, **it );
-        }
+            res.collect_and_spread( level.src_grid->team() );
 
-        /* barrier 'Bob', belongs together with the previous barrier 'Alice' above */
-        (*it)->src_grid->team().barrier();
+            elapsed += minimon.stop( "smoothen_collect", par );
+        }
 
+        // smoothen_wait_face
+        minimon.start();
 
-        cout << "all meet again here: I'm active unit " << dash::myid() << endl;
-        return;
-    }
+        level.src_face_halo->wait( face_regions[f] );
 
+        elapsed += minimon.stop( "smoothen_wait_face", par );
+        level.face_wait[f]= 0.75 * level.face_wait[f] + 0.25 * elapsed;
 
-    /* **** normal recursion **** **** **** **** **** **** **** **** **** */
+        arrived |= 1 << f;
 
-    /* smoothen fixed number of times */
-    uint32_t j= 0;
-    res.reset( (*it)->src_grid->team() );
-    while ( res.get() > epsilon && j < beta ) {
+        // smoothen_face
+        minimon.start();
 
-        /* need global residual for iteration count */
-        smoothen( **it, res );
+        localres= std::max( localres, smoothen_face( level, op, c, f, arrived ) );
 
-        j++;
-    }
-    if ( 0 == dash::myid()  ) {
-        cout << "smoothing on way down " << j << " times with residual " << res.get() << endl;
+        size_t face= ext[(f/2+1)%3] * ext[(f/2+2)%3];
+        elapsed += minimon.stop( "smoothen_face", par, /* elements */ face,
+            /* flops */ 16*face, /*loads*/ 7*face, /* stores */ face, /* bytes per element */ sizeof(T) );
     }
 
-    writeToCsv( **it );
-
-    /* scale down */
-    if ( 0 == dash::myid() ) {
-        cout << "scale down " <<
-            (*it)->src_grid->extent(2) << "×" <<
-            (*it)->src_grid->extent(1) << "×" <<
-            (*it)->src_grid->extent(0) <<
-            " ⇒ " <<
-            (*itnext)->src_grid->extent(2) << "×" <<
-            (*itnext)->src_grid->extent(1) << "×" <<
-            (*itnext)->src_grid->extent(0) << endl;
+    /* order for the next sweep, insertion sort with 10% hysteresis */
+    for ( uint32_t k= 1; k < 6; ++k ) {
+        for ( uint32_t i= k; 0 < i && level.face_wait[order[i]] < 0.9 * level.face_wait[order[i-1]]; --i ) {
+            std::swap( order[i], order[i-1] );
+        }
     }
 
-    scaledown( **it, **itnext );
-    writeToCsv( **itnext );
-
-    /* recurse  */
-    for ( uint32_t g= 0; g < gamma; ++g ) {
-        recursive_cycle( itnext, itend, beta, gamma, epsilon, res );
-    }
+    return localres;
+}
 
-    /* scale up */
-    if ( 0 == dash::myid() ) {
-        cout << "scale up " <<
-            (*itnext)->src_grid->extent(2) << "×" <<
-            (*itnext)->src_grid->extent(1) << "×" <<
-            (*itnext)->src_grid->extent(0) <<
-            " ⇒ " <<
-            (*it)->src_grid->extent(2) << "×" <<
-            (*it)->src_grid->extent(1) << "×" <<
-            (*it)->src_grid->extent(0) << endl;
-    }
-    scaleup( **itnext, **it );
-    writeToCsv( **it );
 
-    j= 0;
-    res.reset( (*it)->src_grid->team() );
-    while ( res.get() > epsilon && j < beta ) {
+/* does nothing, the default for the row hook of smoothen() */
+struct NoRowHook {
 
-        /* need global residual for iteration count */
-        smoothen( **it, res );
+    void operator()( size_t z, size_t y, size_t x, size_t n ) const {}
+};
 
-        j++;
-    }
-    if ( 0 == dash::myid() ) {
-        cout << "smoothing on way up " << j << " times with residual " << res.get() << endl;
-    }
 
-    writeToCsv( **it );
-}
+/**
+Smoothen the given level from oldgrid+src_halo to newgrid. Call Level::swap() at the end.
 
+The parallel global residual is returned as a return parameter, but only
+if it is not NULL because then the expensive parallel reduction is just avoided.
 
-void smoothen_final( Level& level, double epsilon, Allreduce& res ) {
+row_hook( z, y, x, n ) is called after the inner row piece [x,x+n) of row y in
+plane z was updated, by the same thread and while that part of src_grid is still
+in the cache, see smoothen_restrict(). Not with temporal blocking.
+*/
+template< typename T, typename F= NoRowHook >
+double smoothen( LevelT<T>& level, Allreduce& res, double coeff= 1.0, F row_hook= F() ) {
     SCOREP_USER_FUNC()
 
-    uint64_t par= level.src_grid->team().size() ;
+    /* with temporal blocking do level.halo_depth sweeps per halo exchange */
+    if ( 1 < level.halo_depth ) {
+        return smoothen_blocked( level, res, coeff, level.halo_depth );
+    }
 
-    // smooth_final
+    uint32_t par= level.src_grid->team().size();
+
+    // smoothen
+    minimon.start();
+
+    level.src_grid->barrier();
+
+    size_t ld= level.src_grid->local.extent(0);
+    size_t lh= level.src_grid->local.extent(1);
+    size_t lw= level.src_grid->local.extent(2);
+
+    double localres= 0.0;
+
+    double ax= level.ax;
+    double ay= level.ay;
+    double az= level.az;
+    double ac= level.acenter;
+    double ff= level.ff;
+    double m= level.m;
+
+    const double c= coeff;
+
+    // async halo update
+    level.src_face_halo->update_async();
+
+    // smoothen_inner
+    minimon.start();
+
+    // update inner
+
+    /* the start value for both, the y loop and the x loop is 1 because either there is
+    a border area next to the halo -- then the first column or row is covered below in
+    the border update -- or there is an outside border -- then the first column or row
+    contains the boundary values. */
+    /* one x-row at a time with the vectorized kernel, the residual maximum
+    of every row is accumulated in vector registers */
+    /* go through the block in cache tiles, see for_tiles() */
+    StencilKernel7 kernel( ax, ay, az, ac, ff, m, c );
+    const T* p_src= level.src_grid->lbegin();
+    const T* p_rhs= level.rhs_grid->lbegin();
+    T* p_dst= level.dst_grid->lbegin();
+    size_t ty, tx;
+    tile_sizes( lh, lw, sizeof(T), ty, tx );
+#pragma omp parallel reduction(max:localres)
+    for_tiles( 1, ld-1, 1, 1, lh-1, 1, lw-1, ty, tx, [&]( size_t z, size_t y, size_t x, size_t n ) {
+
+        size_t o= ( z * lh + y ) * lw + x;
+        localres= std::max( localres,
+            kernel.row( p_src + o, p_rhs + o, p_dst + o, n, lw, lw*lh ) );
+        row_hook( z, y, x, n );
+    } );
+    minimon.stop( "smoothen_inner", par, /* elements */ (ld-2)*(lh-2)*(lw-2), /* flops */ 16*(ld-2)*(lh-2)*(lw-2), /*loads*/ 7*(ld-2)*(lh-2)*(lw-2), /* stores */ (ld-2)*(lh-2)*(lw-2), /* bytes per element */ sizeof(T) );
+
+    if ( per_face_halo ) {
+
+        /* wait, collect, and update the border face by face */
+        localres= std::max( localres, smoothen_faces( level, res, c ) );
+
+    } else {
+
+        // smoothen_wait
+        minimon.start();
+        // wait for async halo update
+
+        level.src_face_halo->wait();
+
+        minimon.stop( "smoothen_wait", par, /* elements */ ld*lh*lw );
+
+        // smoothen_collect
+        minimon.start();
+
+        /* unit 0 (of any active team) waits until all local residuals from all
+        other active units are in */
+        res.collect_and_spread( level.src_grid->team() );
+
+        minimon.stop( "smoothen_collect", par );
+
+        // smoothen_outer
+        minimon.start();
+
+        localres= std::max( localres, smoothen_border( level, c ) );
+
+        minimon.stop( "smoothen_outer", par, /* elements */ 2*(ld*lh+lh*lw+lw*ld),
+            /* flops */ 16*(ld*lh+lh*lw+lw*ld), /*loads*/ 7*(ld*lh+lh*lw+lw*ld), /* stores */ (ld*lh+lh*lw+lw*ld), /* bytes per element */ sizeof(T) );
+    }
+
+    // smoothen_wait_res
+    minimon.start();
+
+    res.wait( level.src_grid->team() );
+
+    /* global residual from former iteration */
+    double oldres= res.get();
+
+    res.set( &localres, level.src_grid->team() );
+
+    minimon.stop( "smoothen_wait_res", par );
+
+    level.swap();
+
+    minimon.stop( "smoothen", par, /* elements */ ld*lh*lw,
+        /* flops */ 16*ld*lh*lw, /*loads*/ 7*ld*lh*lw, /* stores */ ld*lh*lw, /* bytes per element */ sizeof(T) );
+
+    return oldres;
+}
+
+/**
+Half sweep of the red-black Gauss-Seidel smoother: update all points of the given color
+in place in src_grid. Red (0) and black (1) points are those where the sum of the global
+coordinates is even or odd. Points of one color only read points of the other color,
+therefore no second grid is needed.
+
+Returns the local residual of the updated points.
+*/
+template< typename T >
+double smoothen_color( LevelT<T>& level, uint32_t color, double c ) {
+    SCOREP_USER_FUNC()
+
+    using signed_size_t = typename std::make_signed<size_t>::type;
+
+    const signed_size_t ld= level.src_grid->local.extent(0);
+    const signed_size_t lh= level.src_grid->local.extent(1);
+    const signed_size_t lw= level.src_grid->local.extent(2);
+    const signed_size_t sy= lw;
+    const signed_size_t sz= lw*lh;
+
+    std::array< long int, 3 > corner= level.src_grid->pattern().global( {0,0,0} );
+
+    double ax= level.ax;
+    double ay= level.ay;
+    double az= level.az;
+    double ac= level.acenter;
+    double ff= level.ff;
+    double m= level.m;
+
+    double localres= 0.0;
+
+    level.src_face_halo->update_async();
+
+    /* inner points of this color, x starts at 1 or 2 depending on the parity of the row */
+    T* p_grid= level.src_grid->lbegin();
+    const T* p_rhs= level.rhs_grid->lbegin();
+#pragma omp parallel for schedule(static) reduction(max:localres)
+    for ( signed_size_t z= 1; z < ld-1; z++ ) {
+        for ( signed_size_t y= 1; y < lh-1; y++ ) {
+
+            signed_size_t x0= 1 + ( ( corner[0]+z + corner[1]+y + corner[2]+1 + color ) & 1 );
+            signed_size_t o= (z*lh+y)*lw;
+            for ( signed_size_t x= x0; x < lw-1; x += 2 ) {
+
+                T* p= p_grid + o + x;
+                double dtheta= m * (
+                    ff * p_rhs[o+x] -
+                    ax * ( p[1] + p[-1] ) -
+                    ay * ( p[sy] + p[-sy] ) -
+                    az * ( p[sz] + p[-sz] ) -
+                    ac * *p );
+                *p += c * dtheta;
+
+                localres= std::max( localres, std::fabs( dtheta ) );
+            }
+        }
+    }
+
+    level.src_face_halo->wait();
+
+    /* border area, the halo values belong to the other color and are up to date */
+    auto bend = level.src_op->boundary.end();
+    for( auto it = level.src_op->boundary.begin(); it != bend; ++it ) {
+
+        const auto& coords= it.coords();
+        if ( color != ( ( corner[0]+coords[0] + corner[1]+coords[1] + corner[2]+coords[2] ) & 1 ) ) {
+            continue;
+        }
+
+        double dtheta= m * (
+            ff * p_rhs[ it.lpos() ] -
+            ax * ( it.value_at(4) + it.value_at(5) ) -
+            ay * ( it.value_at(2) + it.value_at(3) ) -
+            az * ( it.value_at(0) + it.value_at(1) ) -
+            ac * *it );
+        p_grid[ it.lpos() ]= *it + c * dtheta;
+
+        localres= std::max( localres, std::fabs( dtheta ) );
+    }
+
+    return localres;
+}
+
+
+/**
+Red-black Gauss-Seidel smoother, works in place on src_grid and needs neither dst_grid nor
+Level::swap(). Every step consists of two half sweeps with a halo exchange each.
+
+Returns the global residual from the former call like smoothen().
+*/
+template< typename T >
+double smoothen_redblack( LevelT<T>& level, Allreduce& res, double coeff= 1.0 ) {
+    SCOREP_USER_FUNC()
+
+    uint32_t par= level.src_grid->team().size();
+
+    size_t ld= level.src_grid->local.extent(0);
+    size_t lh= level.src_grid->local.extent(1);
+    size_t lw= level.src_grid->local.extent(2);
+
+    // smoothen_redblack
+    minimon.start();
+
+    /* the neighbors must have finished their last update before the halo exchange */
+    level.src_grid->barrier();
+
+    double localres= smoothen_color( level, 0, coeff );
+
+    /* unit 0 (of any active team) waits until all local residuals from all
+    other active units are in */
+    res.collect_and_spread( level.src_grid->team() );
+
+    /* all red points must be updated before the halo exchange for the black points */
+    level.src_grid->barrier();
+
+    localres= std::max( localres, smoothen_color( level, 1, coeff ) );
+
+    res.wait( level.src_grid->team() );
+
+    /* global residual from former iteration */
+    double oldres= res.get();
+
+    res.set( &localres, level.src_grid->team() );
+
+    minimon.stop( "smoothen_redblack", par, /* elements */ ld*lh*lw,
+        /* flops */ 16*ld*lh*lw, /*loads*/ 7*ld*lh*lw, /* stores */ ld*lh*lw, /* bytes per element */ sizeof(T) );
+
+    return oldres;
+}
+
+
+/**
+Chebyshev polynomial smoother, one sweep per call. The polynomial of degree chebyshev_degree
+restarts after that many sweeps or whenever level.smoother_step was reset to 0 because
+src_grid was changed from outside.
+
+With x_k in src_grid and the previous iterate x_{k-1} in dst_grid, x_{k+1} overwrites
+x_{k-1} point by point, then Level::swap() is called as in smoothen(). The coefficients only
+depend on an interval of the eigenvalues of D^{-1}A that shall be damped, so unlike
+Krylov methods there are no global reductions during the sweeps. The residual is only
+exchanged at the last sweep of the polynomial.
+
+Returns the global residual from the former exchange.
+*/
+template< typename T >
+double smoothen_chebyshev( LevelT<T>& level, Allreduce& res ) {
+    SCOREP_USER_FUNC()
+
+    uint32_t par= level.src_grid->team().size();
+
+    // smoothen_chebyshev
+    minimon.start();
+
+    level.src_grid->barrier();
+
+    size_t ld= level.src_grid->local.extent(0);
+    size_t lh= level.src_grid->local.extent(1);
+    size_t lw= level.src_grid->local.extent(2);
+
+    double ax= level.ax;
+    double ay= level.ay;
+    double az= level.az;
+    double ac= level.acenter;
+    double ff= level.ff;
+    double m= level.m;
+
+    /* the largest eigenvalue of D^{-1}A is bounded by the Gershgorin circles, which
+    gives 2 for this matrix. The smoother only needs to damp the upper part of the
+    spectrum that the coarse grid cannot represent. There is no cheap bound for where
+    that part starts, so take the usual fraction lmax/30 like other Chebyshev smoothers
+    for multigrid, which also covers anisotropic grids. */
+    double lmax= 1.0 + 2.0 * ( std::fabs( ax ) + std::fabs( ay ) + std::fabs( az ) ) / std::fabs( ac );
+    double lmin= lmax / 30.0;
+    double theta= 0.5 * ( lmax + lmin );
+    double delta= 0.5 * ( lmax - lmin );
+    double sigma= theta / delta;
+
+    /* x_{k+1}= x_k + alpha * ( x_k - x_{k-1} ) + beta * D^{-1}( f - A x_k ) with
+    rho_0= 1/sigma, rho_k= 1/( 2 sigma - rho_{k-1} ), alpha= rho_k rho_{k-1},
+    beta= 2 rho_k / delta and the start x_1= x_0 + 1/theta D^{-1}( f - A x_0 ) */
+    const uint32_t k= level.smoother_step;
+    double rho_prev= 1.0 / sigma;
+    double rho= rho_prev;
+    for ( uint32_t i= 1; i <= k; ++i ) {
+        rho_prev= rho;
+        rho= 1.0 / ( 2.0 * sigma - rho );
+    }
+    const double alpha= ( 0 == k ) ? 0.0 : rho * rho_prev;
+    const double beta= ( 0 == k ) ? 1.0 / theta : 2.0 * rho / delta;
+    const bool last= ( k + 1 == chebyshev_degree );
+
+    double localres= 0.0;
+
+    level.src_face_halo->update_async();
+
+    /* the inner points in cache tiles with the row kernel as in smoothen(). For
+    k == 0 dst_grid may contain anything, so it is not read at all, which is the
+    Jacobi step with the weight beta. */
+    StencilKernel7 kernel( ax, ay, az, ac, ff, m, beta );
+    const T* p_src= level.src_grid->lbegin();
+    const T* p_rhs= level.rhs_grid->lbegin();
+    T* p_dst= level.dst_grid->lbegin();
+    size_t ty, tx;
+    tile_sizes( lh, lw, sizeof(T), ty, tx );
+#pragma omp parallel reduction(max:localres)
+    for_tiles( 1, ld-1, 1, 1, lh-1, 1, lw-1, ty, tx, [&]( size_t z, size_t y, size_t x, size_t n ) {
+
+        size_t o= ( z * lh + y ) * lw + x;
+        if ( 0 == k ) {
+            localres= std::max( localres,
+                kernel.row( p_src + o, p_rhs + o, p_dst + o, n, lw, lw*lh ) );
+        } else {
+            localres= std::max( localres,
+                kernel.row_momentum( p_src + o, p_rhs + o, p_dst + o, n, lw, lw*lh, alpha ) );
+        }
+    } );
+
+    level.src_face_halo->wait();
+
+    if ( last ) {
+        res.collect_and_spread( level.src_grid->team() );
+    }
+
+    auto grid_local_begin= level.dst_grid->lbegin();
+    auto bend = level.src_op->boundary.end();
+    for( auto it = level.src_op->boundary.begin(); it != bend; ++it ) {
+
+        double dtheta= m * (
+            ff * p_rhs[ it.lpos() ] -
+            ax * ( it.value_at(4) + it.value_at(5) ) -
+            ay * ( it.value_at(2) + it.value_at(3) ) -
+            az * ( it.value_at(0) + it.value_at(1) ) -
+            ac * *it );
+        T& dst= grid_local_begin[ it.lpos() ];
+        dst= *it + beta * dtheta + ( ( 0 == k ) ? 0.0 : alpha * ( *it - dst ) );
+
+        localres= std::max( localres, std::fabs( dtheta ) );
+    }
+
+    double oldres= res.get();
+    if ( last ) {
+        res.wait( level.src_grid->team() );
+        oldres= res.get();
+        res.set( &localres, level.src_grid->team() );
+    }
+
+    level.swap();
+    level.smoother_step= ( k + 1 ) % chebyshev_degree;
+
+    minimon.stop( "smoothen_chebyshev", par, /* elements */ ld*lh*lw,
+        /* flops */ 19*ld*lh*lw, /*loads*/ 8*ld*lh*lw, /* stores */ ld*lh*lw, /* bytes per element */ sizeof(T) );
+
+    return oldres;
+}
+
+
+/* one step of the smoother selected by smoother_kind, used in the multigrid cycles */
+template< typename T >
+double smoothen_selected( LevelT<T>& level, Allreduce& res ) {
+
+    switch ( smoother_kind ) {
+
+        case REDBLACK:
+            return smoothen_redblack( level, res );
+        case CHEBYSHEV:
+            return smoothen_chebyshev( level, res );
+        default:
+            return smoothen( level, res, jacobi_weight );
+    }
+}
+
+#ifdef USE_NEW_SCALEUP
+
+/**
+Fused restriction: the last Jacobi sweep of the pre-smoothing of 'fine' that also
+writes the restricted residual f - Au of the new iterate u to the rhs of 'coarse',
+i.e., smoothen() followed by scaledown() but without the separate pass over the
+fine grid for the inner coarse points.
+
+The residual at a coarse point needs the new values of its fine center point and
+its 6 neighbors. Not all of them are written when the sweep passes the point, so
+they are computed again there from the old values in src_grid, which are read in
+that pass anyway. This trades the memory pass for about 14 more flops per fine point.
+The coarse points on the border of the local block need the halo of the new fine
+grid, they are done afterwards by scaledown() without the inner points.
+
+Only for the Jacobi smoother without temporal blocking. Returns the global residual
+from the former call like smoothen().
+*/
+template< typename TF, typename TC >
+double smoothen_restrict( LevelT<TF>& fine, LevelT<TC>& coarse, Allreduce& res ) {
+    SCOREP_USER_FUNC()
+
+    assert( 1 == fine.halo_depth );
+
+    // smoothen_restrict
+    minimon.start();
+
+    const size_t lh= fine.src_grid->local.extent(1);
+    const size_t lw= fine.src_grid->local.extent(2);
+    const size_t sy= lw;
+    const size_t sz= lw*lh;
+
+    const auto& extentc= coarse.src_grid->local.extents();
+
+    /* the inner coarse points 1 .. extentc-2 have the fine points 3 .. 2*extentc-3 */
+    const size_t zmax= 2*extentc[0]-3;
+    const size_t ymax= 2*extentc[1]-3;
+    const size_t xmax= 2*extentc[2]-3;
+
+    double ax= fine.ax;
+    double ay= fine.ay;
+    double az= fine.az;
+    double ac= fine.acenter;
+    double ff= fine.ff;
+    double m= fine.m;
+
+    /* same as in scaledown() */
+    const double extra_factor= 4.0;
+
+    const TF* p_src= fine.src_grid->lbegin();
+    const TF* p_rhs= fine.rhs_grid->lbegin();
+    TC* p_crhs= coarse.rhs_grid->lbegin();
+
+    /* the value after this Jacobi sweep at fine point o */
+    auto unew= [&]( size_t o ) {
+        return p_src[o] + m * (
+            ff * p_rhs[o] -
+            ax * ( p_src[o+1] + p_src[o-1] ) -
+            ay * ( p_src[o+sy] + p_src[o-sy] ) -
+            az * ( p_src[o+sz] + p_src[o-sz] ) -
+            ac * p_src[o] );
+    };
+
+    /* the local corners of fine and coarse grid are at even global coordinates,
+    so the coarse points are at odd local fine coordinates */
+    auto restrict_row= [&]( size_t z, size_t y, size_t x, size_t n ) {
+
+        if ( 0 == ( z & 1 ) || 0 == ( y & 1 ) || z < 3 || y < 3 || z > zmax || y > ymax ) return;
+
+        TC* p_c= p_crhs + ( (z/2) * extentc[1] + y/2 ) * extentc[2];
+        size_t xe= std::min( x + n, xmax + 1 );
+        for ( size_t xf= std::max<size_t>( 3, x | 1 ); xf < xe; xf += 2 ) {
+
+            size_t o= ( z * lh + y ) * lw + xf;
+            p_c[xf/2]= extra_factor * ( ff * p_rhs[o] -
+                ax * ( unew( o+1 ) + unew( o-1 ) ) -
+                ay * ( unew( o+sy ) + unew( o-sy ) ) -
+                az * ( unew( o+sz ) + unew( o-sz ) ) -
+                ac * unew( o ) );
+        }
+    };
+
+    double oldres= smoothen( fine, res, 1.0, restrict_row );
+
+    /* the new fine grid is in src_grid now, scaledown() gets its halo for the border points */
+    scaledown( fine, coarse, false );
+
+    minimon.stop( "smoothen_restrict", fine.src_grid->team().size(), fine.src_grid->local_size() );
+
+    return oldres;
+}
+
+
+/* Prolongation by gathering: add the interpolated correction from 'coarse' to the
+fine points [x0,x1) of row y in plane z of the local block of 'fine'. Per dimension
+an odd fine index 2i+1 takes coarse point i, an even one 2i the mean of i-1 and i,
+which is the same as the scatter in scaleup(). coarse_at( zc, yc, xc ) returns the
+coarse value at local coordinates that may be in the halo. */
+template< typename TF, typename C >
+inline void prolongate_row( TF* p_fine, size_t lh, size_t lw, long z, long y, long x0, long x1,
+        C coarse_at ) {
+
+    long zc[2], yc[2];
+    double wz[2], wy[2];
+    int nz= ( z & 1 ) ? 1 : 2;
+    int ny= ( y & 1 ) ? 1 : 2;
+    zc[0]= ( z & 1 ) ? z/2 : z/2-1; zc[1]= z/2; wz[0]= wz[1]= ( z & 1 ) ? 1.0 : 0.5;
+    yc[0]= ( y & 1 ) ? y/2 : y/2-1; yc[1]= y/2; wy[0]= wy[1]= ( y & 1 ) ? 1.0 : 0.5;
+
+    TF* p= p_fine + ( z * lh + y ) * lw;
+    for ( long x= x0; x < x1; ++x ) {
+
+        long xc0= ( x & 1 ) ? x/2 : x/2-1;
+        long xc1= x/2;
+        double v= 0.0;
+        for ( int a= 0; a < nz; ++a ) {
+            for ( int b= 0; b < ny; ++b ) {
+
+                double w= wz[a] * wy[b];
+                v += ( x & 1 ) ? w * coarse_at( zc[a], yc[b], xc1 ) :
+                    0.5 * w * ( coarse_at( zc[a], yc[b], xc0 ) + coarse_at( zc[a], yc[b], xc1 ) );
+            }
+        }
+        p[x] += v;
+    }
+}
+
+
+/**
+Fused prolongation: scaleup() from 'coarse' to 'fine' together with the first Jacobi
+sweep of the post-smoothing on 'fine', without the separate pass over the fine grid.
+
+The interpolated correction is gathered per fine point instead of scattered from the
+coarse points. First the border layer of the local fine block gets its correction,
+which needs the coarse halo, then the halo exchange of the fine grid starts. Then every
+thread goes through its chunk of inner planes as a wavefront, where plane z+1 gets its
+correction right before plane z is smoothed, so both are still in the cache. The first
+and the last plane of every chunk are corrected before, because the neighboring threads
+read them.
+
+Only for the Jacobi smoother without temporal blocking. Returns the global residual
+from the former call like smoothen().
+*/
+template< typename TC, typename TF >
+double scaleup_smoothen( LevelT<TC>& coarse, LevelT<TF>& fine, Allreduce& res ) {
+    SCOREP_USER_FUNC()
+
+    assert( 1 == fine.halo_depth );
+
+    uint32_t par= fine.src_grid->team().size();
+
+    // scaleup_smoothen
+    minimon.start();
+
+    const long ld= fine.src_grid->local.extent(0);
+    const long lh= fine.src_grid->local.extent(1);
+    const long lw= fine.src_grid->local.extent(2);
+
+    const auto& extentc= coarse.src_grid->local.extents();
+    const auto& cornerc= coarse.src_grid->pattern().global( {0,0,0} );
+    const long dc[3]= { (long) coarse.src_grid->extent(0), (long) coarse.src_grid->extent(1),
+        (long) coarse.src_grid->extent(2) };
+
+    assert( (long) extentc[0] * 2 == ld || (long) extentc[0] * 2 +1 == ld );
+    assert( (long) extentc[1] * 2 == lh || (long) extentc[1] * 2 +1 == lh );
+    assert( (long) extentc[2] * 2 == lw || (long) extentc[2] * 2 +1 == lw );
+
+    const TC* p_coarse= coarse.src_grid->lbegin();
+    TF* p_fine= fine.src_grid->lbegin();
+
+    /* the neighbors must not read the coarse grid before it is complete */
+    coarse.src_grid->barrier();
+    coarse.src_halo->update();
+
+    /* the coarse value at local coordinates, from the halo outside of the local
+    block and 0.0 outside of the global grid like the boundary of the corrections */
+    auto coarse_halo_at= [&]( long zc, long yc, long xc ) -> double {
+
+        if ( 0 <= zc && zc < (long) extentc[0] && 0 <= yc && yc < (long) extentc[1] &&
+                0 <= xc && xc < (long) extentc[2] ) {
+            return p_coarse[ ( zc * extentc[1] + yc ) * extentc[2] + xc ];
+        }
+        if ( cornerc[0] + zc < 0 || cornerc[0] + zc >= dc[0] ||
+                cornerc[1] + yc < 0 || cornerc[1] + yc >= dc[1] ||
+                cornerc[2] + xc < 0 || cornerc[2] + xc >= dc[2] ) {
+            return 0.0;
+        }
+        const TC* h= coarse.src_halo->halo_element_at_local( {zc,yc,xc} );
+        return ( nullptr == h ) ? 0.0 : *h;
+    };
+    auto coarse_local_at= [&]( long zc, long yc, long xc ) -> double {
+        return p_coarse[ ( zc * extentc[1] + yc ) * extentc[2] + xc ];
+    };
+
+    /* 1) correction of the border layer of the local fine block */
+    for ( long z= 0; z < ld; ++z ) {
+        for ( long y= 0; y < lh; ++y ) {
+
+            if ( 0 == z || ld-1 == z || 0 == y || lh-1 == y ) {
+                prolongate_row( p_fine, lh, lw, z, y, 0, lw, coarse_halo_at );
+            } else {
+                prolongate_row( p_fine, lh, lw, z, y, 0, 1, coarse_halo_at );
+                prolongate_row( p_fine, lh, lw, z, y, lw-1, lw, coarse_halo_at );
+            }
+        }
+    }
+
+    /* 2) the neighbors read this border layer in their halo exchange */
+    fine.src_grid->barrier();
+    fine.src_face_halo->update_async();
+
+    /* 3) wavefront of correction and Jacobi sweep over the inner planes,
+    the inner fine points only need local coarse points */
+    StencilKernel7 kernel( fine.ax, fine.ay, fine.az, fine.acenter, fine.ff, fine.m, 1.0 );
+    const TF* p_rhs= fine.rhs_grid->lbegin();
+    TF* p_dst= fine.dst_grid->lbegin();
+    double localres= 0.0;
+#pragma omp parallel reduction(max:localres)
+    {
+        size_t kb, ke;
+        thread_chunk( ld-2, kb, ke );
+        long zb= 1 + kb;
+        long ze= 1 + ke;
+
+        auto correct_plane= [&]( long z ) {
+            for ( long y= 1; y < lh-1; ++y ) {
+                prolongate_row( p_fine, lh, lw, z, y, 1, lw-1, coarse_local_at );
+            }
+        };
+
+        if ( zb < ze ) {
+            correct_plane( zb );
+            if ( zb < ze-1 ) correct_plane( ze-1 );
+        }
+#pragma omp barrier
+
+        for ( long z= zb; z < ze; ++z ) {
+
+            if ( z+1 < ze-1 ) correct_plane( z+1 );
+
+            for ( long y= 1; y < lh-1; ++y ) {
+
+                size_t o= ( z * lh + y ) * lw + 1;
+                localres= std::max( localres,
+                    kernel.row( p_fine + o, p_rhs + o, p_dst + o, lw-2, lw, lw*lh ) );
+            }
+        }
+    }
+
+    /* 4) the border points as in smoothen() */
+    fine.src_face_halo->wait();
+
+    res.collect_and_spread( fine.src_grid->team() );
+
+    localres= std::max( localres, smoothen_border( fine, 1.0 ) );
+
+    res.wait( fine.src_grid->team() );
+
+    /* global residual from former iteration */
+    double oldres= res.get();
+
+    res.set( &localres, fine.src_grid->team() );
+
+    fine.swap();
+    fine.smoother_step= 0;
+
+    minimon.stop( "scaleup_smoothen", par, /* elements */ ld*lh*lw,
+        /* flops */ 18*ld*lh*lw, /*loads*/ 8*ld*lh*lw, /* stores */ 2*ld*lh*lw, /* bytes per element */ sizeof(TF) );
+
+    return oldres;
+}
+
+#endif /* USE_NEW_SCALEUP */
+
+//#define DETAILOUTPUT 1
+
+/* out= A*src_grid of the level with the 7-point stencil, including the boundary
+values from the halo. The halo exchange overlaps the inner points, the points
+next to the halo are done afterwards with a stencil operator on the face halo
+like in scaledown(). */
+template< typename T >
+void apply_operator( LevelT<T>& level, typename LevelT<T>::MatrixT& out ) {
+    SCOREP_USER_FUNC()
+
+    uint32_t par= level.src_grid->team().size();
+
+    // apply_operator
+    minimon.start();
+
+    FaceSpecT spec(
+      StencilT(level.az, -1, 0, 0), StencilT(level.az, 1, 0, 0),
+      StencilT(level.ay,  0,-1, 0), StencilT(level.ay, 0, 1, 0),
+      StencilT(level.ax,  0, 0,-1), StencilT(level.ax, 0, 0, 1)
+    );
+
+    level.src_grid->barrier();
+    level.src_face_halo->update_async();
+
+    size_t ld= level.src_grid->local.extent(0);
+    size_t lh= level.src_grid->local.extent(1);
+    size_t lw= level.src_grid->local.extent(2);
+    size_t sz= lh*lw;
+
+    double ax= level.ax;
+    double ay= level.ay;
+    double az= level.az;
+    double ac= level.acenter;
+
+    const T* p= level.src_grid->lbegin();
+    T* q= out.lbegin();
+#pragma omp parallel for schedule(static)
+    for ( size_t z= 1; z < ld-1; z++ ) {
+        for ( size_t y= 1; y < lh-1; y++ ) {
+            for ( size_t x= 1; x < lw-1; x++ ) {
+
+                size_t o= ( z * lh + y ) * lw + x;
+                q[o]= ac * p[o] +
+                    ax * ( p[o-1] + p[o+1] ) +
+                    ay * ( p[o-lw] + p[o+lw] ) +
+                    az * ( p[o-sz] + p[o+sz] );
+            }
+        }
+    }
+
+    level.src_face_halo->wait();
+
+    auto op= level.src_face_halo->stencil_operator( spec );
+    auto bend= op.boundary.end();
+    for ( auto it= op.boundary.begin(); it != bend; ++it ) {
+        q[ it.lpos() ]= op.boundary.get_value_at( it.coords(), ac );
+    }
+
+    minimon.stop( "apply_operator", par, /* elements */ ld*lh*lw,
+        /* flops */ 10*ld*lh*lw, /*loads*/ 7*ld*lh*lw, /* stores */ ld*lh*lw, /* bytes per element */ sizeof(T) );
+}
+
+
+/* Restriction with full weighting instead of injection like in scaledown(). The
+defect d= ff*rhs - A*src of the fine level goes to its dst_grid, which is free
+between two smoother calls. Every coarse rhs point is then 4 times the average
+of the 27 fine defects around it with the weights 1, 1/2, 1/4, and 1/8 of
+'stencil_spec', which is the transpose of the trilinear prolongation in scaleup()
+up to a constant. Only with it the V-cycle is a symmetric operator, as needed for
+the preconditioner of CG. It costs a second pass over the fine grid and a halo
+exchange with edges and corners. */
+template< typename TF, typename TC >
+void scaledown_fullweighting( LevelT<TF>& fine, LevelT<TC>& coarse ) {
+    SCOREP_USER_FUNC()
+    using signed_size_t = typename std::make_signed<size_t>::type;
+
+    auto& defect= *fine.dst_grid;
+    auto& coarsegrid= *coarse.src_grid;
+    auto& coarse_rhs_grid= *coarse.rhs_grid;
+
+    apply_operator( fine, defect );
+
+    // scaledown_fullweighting
+    minimon.start();
+
+    size_t n= defect.local_size();
+    TF* pd= defect.lbegin();
+    const TF* pf= fine.rhs_grid->lbegin();
+    double ff= fine.ff;
+#pragma omp parallel for schedule(static)
+    for ( size_t i= 0; i < n; ++i ) {
+        pd[i]= ff * pf[i] - pd[i];
+    }
+    fine.dst_halo->update();
+
+    const auto& extentc= coarsegrid.local.extents();
+    auto& op= *fine.dst_full_op;
+    double factor= 4.0 / 8.0;
+
+#pragma omp parallel for schedule(static)
+    for ( signed_size_t z= 1; z < (signed_size_t) extentc[0] - 1; z++ ) {
+        for ( signed_size_t y= 1; y < (signed_size_t) extentc[1] - 1; y++ ) {
+            for ( signed_size_t x= 1; x < (signed_size_t) extentc[2] - 1; x++ ) {
+                coarse_rhs_grid.local[z][y][x]= factor *
+                    op.inner.get_value_at( {2*z+1,2*y+1,2*x+1}, 1.0 );
+            }
+        }
+    }
+
+    auto& stencil_op_coarse = *coarse.src_op;
+    auto* coarse_rhs_begin = coarse_rhs_grid.lbegin();
+    auto bend = stencil_op_coarse.boundary.end();
+    for( auto it = stencil_op_coarse.boundary.begin(); it != bend; ++it ) {
+      const auto& coords = it.coords();
+      decltype(coords) coords_fine = {2*coords[0] + 1, 2*coords[1] + 1, 2*coords[2] + 1};
+      coarse_rhs_begin[it.lpos()] = factor * op.boundary.get_value_at(coords_fine, 1.0);
+    }
+
+    dash::fill( coarsegrid.begin(), coarsegrid.end(), 0.0 );
+
+    coarse.rhs_dirty= true;
+    coarse.smoother_step= 0;
+    fine.smoother_step= 0;
+
+    minimon.stop( "scaledown_fullweighting", fine.src_grid->team().size(), n,
+        /* flops */ 2*n, /*loads*/ 2*n + 27*coarsegrid.local_size(), /* stores */ n + coarsegrid.local_size(), /* bytes per element */ sizeof(TF) );
+}
+
+
+template<typename Iterator>
+void recursive_cycle( Iterator it, Iterator itend,
+        uint32_t beta, uint32_t gamma, double epsilon, Allreduce& res, bool fcycle= false ) {
+    SCOREP_USER_FUNC()
+
+    Iterator itnext( it );
+    ++itnext;
+    /* reached end of recursion? */
+    if ( itend == itnext ) {
+
+        /* smoothen completely  */
+        uint32_t j= 0;
+        res.reset( (*it)->src_grid->team() );
+        while ( res.get() > epsilon ) {
+            /* need global residual for iteration count */
+            smoothen_selected( **it, res );
+
+            j += (*it)->halo_depth;
+        }
+        if ( cycle_output && 0 == dash::myid() ) {
+            cout << "smoothing coarsest " << j << " times with residual " << res.get() << endl;
+        }
+        if ( cycle_output ) writeToCsv( **it );
+
+        return;
+    }
+
+    /* stepped on the dummy level? ... which is there to signal that it is not
+    the end of the parallel recursion on the coarsest level but a subteam is
+    going on to solve the coarser levels and this unit is not in that subteam.
+    ... sounds complicated, is complicated, change only if you know what you
+    are doing. */
+    if ( NULL == *itnext ) {
+
+        /* barrier 'Alice', belongs together with the next barrier 'Bob' below */
+        (*it)->src_grid->team().barrier();
+
+        cout << "all meet again here: I'm passive unit " << dash::myid() << endl;
+
+        return;
+    }
+
+    /* stepped on a transfer level? */
+    if ( (*it)->src_grid->team().size() != (*itnext)->src_grid->team().size() ) {
+
+        /* only the members of the reduced team need to work, all others do siesta. */
+        //if ( 0 == (*itnext)->grid.team().position() )
+        assert( 0 == (*itnext)->src_grid->team().position() );
+        {
+
+            cout << "transfer to " <<
+                (*it)->src_grid->extent(2) << "×" <<
+                (*it)->src_grid->extent(1) << "×" <<
+                (*it)->src_grid->extent(0) << " with " << (*it)->src_grid->team().size() << " units "
+                " ⇒ " <<
+                (*itnext)->src_grid->extent(2) << "×" <<
+                (*itnext)->src_grid->extent(1) << "×" <<
+                (*itnext)->src_grid->extent(0) << " with " << (*itnext)->src_grid->team().size() << " units " << endl;
+
+            transfertofewer( **it, **itnext );
+
+            /* don't apply a gamma != 1 here! */
+            recursive_cycle( itnext, itend, beta, gamma, epsilon, res, fcycle );
+
+            cout << "transfer back " <<
+            (*itnext)->src_grid->extent(2) << "×" <<
+            (*itnext)->src_grid->extent(1) << "×" <<
+            (*itnext)->src_grid->extent(0) << " with " << (*itnext)->src_grid->team().size() << " units "
+            " ⇒ " <<
+            (*it)->src_grid->extent(2) << "×" <<
+            (*it)->src_grid->extent(1) << "×" <<
+            (*it)->src_grid->extent(0) << " with " << (*it)->src_grid->team().size() << " units " <<  endl;
+
+            transfertomore( **itnext, **it );
+        }
+
+        /* barrier 'Bob', belongs together with the previous barrier 'Alice' above */
+        (*it)->src_grid->team().barrier();
+
+
+        cout << "all meet again here: I'm active unit " << dash::myid() << endl;
+        return;
+    }
+
+
+    /* **** normal recursion **** **** **** **** **** **** **** **** **** */
+
+#ifdef USE_NEW_SCALEUP
+    bool fused= use_fused && JACOBI == smoother_kind && 1 == (*it)->halo_depth &&
+        1.0 == jacobi_weight && ! full_weighting;
+#else /* USE_NEW_SCALEUP */
+    bool fused= false;
+#endif /* USE_NEW_SCALEUP */
+    bool restricted= false;
+
+    /* smoothen fixed number of times */
+    uint32_t j= 0;
+    res.reset( (*it)->src_grid->team() );
+    while ( res.get() > epsilon && j < beta ) {
+
+        /* need global residual for iteration count */
+#ifdef USE_NEW_SCALEUP
+        if ( fused && j + 1 >= beta ) {
+
+            /* the last sweep also does the restriction */
+            smoothen_restrict( **it, **itnext, res );
+            restricted= true;
+        } else
+#endif /* USE_NEW_SCALEUP */
+        smoothen_selected( **it, res );
+
+        j += (*it)->halo_depth;
+    }
+    if ( cycle_output && 0 == dash::myid() ) {
+        cout << "smoothing on way down " << j << " times with residual " << res.get() << endl;
+    }
+
+    if ( cycle_output ) writeToCsv( **it );
+
+    /* scale down */
+    if ( cycle_output && 0 == dash::myid() ) {
+        cout << "scale down " <<
+            (*it)->src_grid->extent(2) << "×" <<
+            (*it)->src_grid->extent(1) << "×" <<
+            (*it)->src_grid->extent(0) <<
+            " ⇒ " <<
+            (*itnext)->src_grid->extent(2) << "×" <<
+            (*itnext)->src_grid->extent(1) << "×" <<
+            (*itnext)->src_grid->extent(0) << endl;
+    }
+
+    if ( restricted ) {
+    } else if ( full_weighting ) {
+        scaledown_fullweighting( **it, **itnext );
+    } else {
+        scaledown( **it, **itnext );
+    }
+    if ( cycle_output ) writeToCsv( **itnext );
+
+    /* recurse  */
+    if ( fcycle ) {
+
+        /* F-cycle: F-cycle on the coarser level followed by a V-cycle there */
+        recursive_cycle( itnext, itend, beta, 1, epsilon, res, true );
+        recursive_cycle( itnext, itend, beta, 1, epsilon, res, false );
+
+    } else {
+
+        for ( uint32_t g= 0; g < gamma; ++g ) {
+            recursive_cycle( itnext, itend, beta, gamma, epsilon, res );
+        }
+    }
+
+    /* scale up */
+    if ( cycle_output && 0 == dash::myid() ) {
+        cout << "scale up " <<
+            (*itnext)->src_grid->extent(2) << "×" <<
+            (*itnext)->src_grid->extent(1) << "×" <<
+            (*itnext)->src_grid->extent(0) <<
+            " ⇒ " <<
+            (*it)->src_grid->extent(2) << "×" <<
+            (*it)->src_grid->extent(1) << "×" <<
+            (*it)->src_grid->extent(0) << endl;
+    }
+    j= 0;
+    res.reset( (*it)->src_grid->team() );
+#ifdef USE_NEW_SCALEUP
+    if ( fused && 0 < beta ) {
+
+        /* the first sweep also does the prolongation */
+        scaleup_smoothen( **itnext, **it, res );
+        j += (*it)->halo_depth;
+    } else
+#endif /* USE_NEW_SCALEUP */
+    {
+        scaleup( **itnext, **it );
+        if ( cycle_output ) writeToCsv( **it );
+    }
+
+    while ( res.get() > epsilon && j < beta ) {
+
+        /* need global residual for iteration count */
+        smoothen_selected( **it, res );
+
+        j += (*it)->halo_depth;
+    }
+    if ( cycle_output && 0 == dash::myid() ) {
+        cout << "smoothing on way up " << j << " times with residual " << res.get() << endl;
+    }
+
+    if ( cycle_output ) writeToCsv( **it );
+}
+
+
+/**
+Full multigrid: solve the original problem on the coarsest level, then prolongate
+the solution to the next finer level as the initial guess there and improve it
+with one cycle down to the coarsest level. Repeat up to the finest level.
+
+Unlike in the cycles, where the coarser levels solve for the correction with zero
+boundary values and the restricted residual as right hand side, here every level
+first gets the original boundary values and a zero right hand side. A level is set
+back to zero boundary values as soon as it only serves as a coarser level for the
+cycles above it.
+
+Works only with all levels on the same team, i.e., not in elastic mode.
+*/
+template<typename Iterator>
+void fmg_cycle( Iterator itbegin, Iterator itend,
+        uint32_t beta, uint32_t gamma, double epsilon, Allreduce& res, bool fcycle ) {
+    SCOREP_USER_FUNC()
+
+    // fmg
+    minimon.start();
+
+    size_t n= itend - itbegin;
+
+    /* the original problem on all levels, the finest one has it already */
+    for ( size_t l= 1; l < n; ++l ) {
+
+        initboundary( *itbegin[l] );
+        initgrid( *itbegin[l] );
+    }
+
+    /* solve on the coarsest level */
+    Level& coarsest= *itbegin[n-1];
+    uint32_t j= 0;
+    res.reset( coarsest.src_grid->team() );
+    while ( res.get() > epsilon ) {
+
+        smoothen_selected( coarsest, res );
+        j += coarsest.halo_depth;
+    }
+    if ( 0 == dash::myid() ) {
+        cout << "fmg: solve coarsest " << j << " times with residual " << res.get() << endl;
+    }
+
+    for ( size_t l= n-1; l > 0; --l ) {
+
+        Level& coarse= *itbegin[l];
+        Level& fine= *itbegin[l-1];
+
+        if ( 0 == dash::myid() ) {
+            cout << "fmg: interpolate " <<
+                coarse.src_grid->extent(2) << "×" <<
+                coarse.src_grid->extent(1) << "×" <<
+                coarse.src_grid->extent(0) <<
+                " ⇒ " <<
+                fine.src_grid->extent(2) << "×" <<
+                fine.src_grid->extent(1) << "×" <<
+                fine.src_grid->extent(0) << endl;
+        }
+
+        /* scaleup() adds the interpolated values, so start from zero */
+        initgrid( fine );
+        scaleup( coarse, fine );
+
+        /* from now on the coarse level only solves for corrections */
+        initboundary_zero( coarse );
+
+        recursive_cycle( itbegin + (l-1), itend, beta, gamma, epsilon, res, fcycle );
+        writeToCsv( fine );
+    }
+
+    minimon.stop( "fmg", coarsest.src_grid->team().size() );
+}
+
+
+void smoothen_final( Level& level, double epsilon, Allreduce& res ) {
+    SCOREP_USER_FUNC()
+
+    uint64_t par= level.src_grid->team().size() ;
+
+    // smooth_final
     minimon.start();
 
     uint32_t j= 0;
     res.reset( level.src_grid->team() );
     while ( res.get() > epsilon ) {
 
-        smoothen( level, res );
-        j++;
-        if ( ( 0 == dash::myid() ) && ( 0 == j % 100 ) ) {
+        smoothen_selected( level, res );
+        j += level.halo_depth;
+        if ( ( 0 == dash::myid() ) && ( 0 == j % ( 100 * level.halo_depth ) ) ) {
             cout << j << "smoothen finest, residual " << res.get() << "    "<< fflush << "\r";
         }
 
     }
     if ( 0 == dash::myid() ) {
-        cout << "smoothing: " << j << " steps finest with residual " << res.get() << endl;
+        cout << "smoothing: " << j << " steps finest with residual " << res.get() << endl;
+    }
+
+/////////////////////////////////////////
+#ifdef DETAILOUTPUT
+if ( 0 == dash::myid()  ) {
+    cout << "== after final smoothing ==" << endl;
+    cout << "  src_grid" << endl;
+    level.printout();
+    cout << "  rhs_grid" << endl;
+    level.printout_rhs();
+}
+#endif /* DETAILOUTPUT */
+
+    minimon.stop( "smooth_final", par );
+}
+
+
+void do_multigrid_iteration( uint32_t howmanylevels, double eps, std::array< double, 3 >& dim ) {
+    SCOREP_USER_FUNC()
+
+    // setup
+    minimon.start();
+
+    TeamSpecT teamspec( dash::Team::All().size(), 1, 1 );
+    teamspec.balance_extents();
+
+    /* determine factors for width and height such that every unit has a power of two
+    extent in every dimension and that the area is close to a square
+    with aspect ratio \in [0,75,1,5] */
+
+    vector<Level*> levels;
+    levels.reserve( howmanylevels );
+
+    if ( 0 == dash::myid() ) {
+
+        cout << "run multigrid iteration with " << dash::Team::All().size() << " units "
+            "for with grids from " <<
+            2 << "×" <<
+            2 << "×" <<
+            2 <<
+            " to " <<
+            ((1<<(howmanylevels))-1) << "×" <<
+            ((1<<(howmanylevels))-1) << "×" <<
+            ((1<<(howmanylevels))-1) <<
+            endl;
+    }
+
+    /* finest grid needs to be larger than 2*teamspec per dimension,
+    that means local grid is >= 2 elements */
+    assert( (1<<(howmanylevels))-1 >= 2*teamspec.num_units(0) );
+    assert( (1<<(howmanylevels))-1 >= 2*teamspec.num_units(1) );
+    assert( (1<<(howmanylevels))-1 >= 2*teamspec.num_units(2) );
+
+    /* create all grid levels, starting with the finest and ending with 2x2,
+    The finest level is outside the loop because it is always done by dash::Team::All() */
+
+    if ( 0 == dash::myid() ) {
+        cout << "finest level is " <<
+            (1<<(howmanylevels))-1 << "×" <<
+            (1<<(howmanylevels))-1 << "×" <<
+            (1<<(howmanylevels))-1 <<
+            " distributed over " <<
+            teamspec.num_units(0) << "×" <<
+            teamspec.num_units(1) << "×" <<
+            teamspec.num_units(2) << " units" << endl;
+    }
+
+    levels.push_back( level_pool.acquire( dim[0], dim[1], dim[2],
+        (1<<(howmanylevels))-1,
+        (1<<(howmanylevels))-1,
+        (1<<(howmanylevels))-1,
+        dash::Team::All(), teamspec ) );
+
+    /* only do initgrid on the finest level, use scaledownboundary for all others */
+    initboundary( *levels.back() );
+
+    dash::barrier();
+
+    --howmanylevels;
+    while ( (1<<(howmanylevels))-1 >= 2*teamspec.num_units(0) &&
+            (1<<(howmanylevels))-1 >= 2*teamspec.num_units(1) &&
+            (1<<(howmanylevels))-1 >= 2*teamspec.num_units(2) ) {
+
+        /*
+        if ( 0 == dash::myid() ) {
+            cout << "compute level " << l << " is " <<
+                (1<<(howmanylevels))-1 << "×" <<
+                (1<<(howmanylevels))-1 << "×" <<
+                (1<<(howmanylevels))-1 <<
+                " distributed over " <<
+                teamspec.num_units(0) << "×" <<
+                teamspec.num_units(1) << "×" <<
+                teamspec.num_units(2) << " units" << endl;
+        }
+        */
+
+        /* do not try to allocate >= 8GB per core -- try to prevent myself
+        from running too big a simulation on my laptop */
+        assert( ((1<<(howmanylevels))-1) *
+            ((1<<(howmanylevels))-1) *
+            ((1<<(howmanylevels))-1) < dash::Team::All().size() * (1<<27) );
+
+        Level& previouslevel= *levels.back();
+
+        levels.push_back(
+            level_pool.acquire( previouslevel,
+                       (1<<(howmanylevels))-1,
+                       (1<<(howmanylevels))-1,
+                       (1<<(howmanylevels))-1,
+                       dash::Team::All(), teamspec ) );
+
+        /* scaledown boundary instead of initializing it from the same
+        procedure, because this is very prone to subtle mistakes which
+        makes the entire multigrid algorithm misbehave. */
+        //scaledownboundary( previouslevel, *levels.back() );
+
+        initboundary_zero( *levels.back() );
+
+        dash::barrier();
+        --howmanylevels;
+    }
+
+    /* here all units and all teams meet again, those that were active for the coarsest
+    levels and those that were dormant */
+    dash::Team::All().barrier();
+
+    /* Fill finest level. Strictly, we don't need to set any initial values here
+    but we do it for demonstration in the graphical output */
+    initgrid( *levels.front() );
+    //markunits( *levels.front()->src_grid );
+
+    writeToCsv( *levels.front() );
+
+    dash::Team::All().barrier();
+
+    Allreduce res( dash::Team::All() );
+
+    minimon.stop( "setup", dash::Team::All().size() );
+
+    //v_cycle( levels.begin(), levels.end(), 20, eps, res );
+    //recursive_cycle( levels.begin(), levels.end(), 20, 1 /* 1 for v cycle */, eps, res );
+
+    if ( use_fmg ) {
+
+        /* the last step of full multigrid is a cycle on the finest level */
+        if ( 0 == dash::myid()  ) {
+            cout << "start full multigrid with res " << eps << endl << endl;
+        }
+        fmg_cycle( levels.begin(), levels.end(), 20, cycle_gamma, eps, res, cycle_f );
+
+    } else {
+
+        if ( 0 == dash::myid()  ) {
+            cout << "start " << ( cycle_f ? "f" : 1 == cycle_gamma ? "v" : 2 == cycle_gamma ? "w" : "gamma" ) <<
+                "-cycle with res " << eps << endl << endl;
+        }
+        //w_cycle( levels.begin(), levels.end(), 20, eps, res );
+        recursive_cycle( levels.begin(), levels.end(), 20, cycle_gamma /* 1 for v cycle, 2 for w cycle */, eps, res, cycle_f );
+    }
+    dash::Team::All().barrier();
+
+
+    if ( 0 == dash::myid()  ) {
+        cout << "final smoothing with res " << eps << endl;
+    }
+    smoothen_final( *levels.front(), eps, res );
+    writeToCsv( *levels.front() );
+
+    dash::Team::All().barrier();
+
+    if ( 0 == dash::myid() ) {
+
+        if ( ! check_symmetry( *levels.front()->src_grid, eps ) ) {
+
+            cout << "test for asymmetry of soution failed!" << endl;
+        }
     }
 
-/////////////////////////////////////////
-#ifdef DETAILOUTPUT
-if ( 0 == dash::myid()  ) {
-    cout << "== after final smoothing ==" << endl;
-    cout << "  src_grid" << endl;
-    level.printout();
-    cout << "  rhs_grid" << endl;
-    level.printout_rhs();
+    for ( Level* l : levels ) {
+        level_pool.release( l );
+    }
 }
-#endif /* DETAILOUTPUT */
 
-    minimon.stop( "smooth_final", par );
+
+/* sum of a[i]*b[i] over the local elements */
+double local_dot( const MatrixT& a, const MatrixT& b ) {
+
+    size_t n= a.local_size();
+    const double* pa= a.lbegin();
+    const double* pb= b.lbegin();
+    double sum= 0.0;
+#pragma omp parallel for schedule(static) reduction(+:sum)
+    for ( size_t i= 0; i < n; ++i ) {
+        sum += pa[i] * pb[i];
+    }
+
+    return sum;
 }
 
 
-void do_multigrid_iteration( uint32_t howmanylevels, double eps, std::array< double, 3 >& dim ) {
+/**
+Multigrid preconditioned conjugate gradients (MGCG). The solution is the src_grid
+of the finest level with the original boundary values. The preconditioner is one
+V-cycle with mgcg_sweeps Jacobi sweeps on a second hierarchy of levels with zero
+boundary values, which solves A z = r for the correction z. Its finest level holds
+the residual r in the rhs_grid and z in the src_grid, which gives z a halo for A*z.
+
+CG needs a symmetric positive definite preconditioner. Therefore, the V-cycle
+restricts with full weighting, see scaledown_fullweighting(), instead of the
+injection, and the Jacobi sweeps are damped with 6/7 because plain Jacobi does not
+damp the checkerboard mode at all. As the coarsest level is only solved up to a
+tolerance, it uses the flexible beta= (z, r - r_old)/gamma_old anyway. With s= A p
+kept as a vector like in the Chronopoulos/Gear variant of CG, all dot products are
+available early:
+
+    z= M r, gamma= (r,z), zeta= (z,s), w= A z, delta= (z,w),
+    beta= -alpha_old*zeta/gamma_old, (p,s)= delta + 2*beta*zeta + beta^2*(p,s)_old,
+    alpha= gamma/(p,s), p= z + beta p, s= w + beta s, x= x + alpha p, r= r - alpha s
+
+The reduction of gamma, zeta, and (r,r) runs while A z does its halo exchange,
+and the one of delta while p and s are updated, since those only need beta.
+
+The iteration stops when the root mean square of m*r, comparable to the residual
+of the smoother in the other modes, is below eps. With strongly anisotropic grids
+('-d' with very different extents) point Jacobi smooths badly and plain V-cycles
+converge slowly, but as a preconditioner they still give a nearly constant number
+of CG iterations.
+
+Works only with all levels on the same team, i.e., not in elastic mode.
+*/
+void do_mgcg( uint32_t howmanylevels, double eps, std::array< double, 3 >& dim ) {
     SCOREP_USER_FUNC()
 
     // setup
@@ -3001,149 +4967,559 @@ void do_multigrid_iteration( uint32_t howmanylevels, double eps, std::array< dou
     TeamSpecT teamspec( dash::Team::All().size(), 1, 1 );
     teamspec.balance_extents();
 
-    /* determine factors for width and height such that every unit has a power of two
-    extent in every dimension and that the area is close to a square
-    with aspect ratio \in [0,75,1,5] */
+    assert( (1<<(howmanylevels))-1 >= 2*teamspec.num_units(0) );
+    assert( (1<<(howmanylevels))-1 >= 2*teamspec.num_units(1) );
+    assert( (1<<(howmanylevels))-1 >= 2*teamspec.num_units(2) );
+
+    size_t n= (1<<(howmanylevels))-1;
+
+    if ( 0 == dash::myid() ) {
 
+        cout << "run multigrid preconditioned CG with " << dash::Team::All().size() <<
+            " units for grid of " << n << "×" << n << "×" << n <<
+            " with " << mgcg_sweeps << " sweeps per V-cycle" << endl;
+    }
+
+    Level& fine= *level_pool.acquire( dim[0], dim[1], dim[2], n, n, n, dash::Team::All(), teamspec );
+    initboundary( fine );
+    initgrid( fine );
+
+    /* the hierarchy for the preconditioner */
     vector<Level*> levels;
     levels.reserve( howmanylevels );
+    levels.push_back( level_pool.acquire( dim[0], dim[1], dim[2], n, n, n, dash::Team::All(), teamspec ) );
+    initboundary_zero( *levels.back() );
+    initgrid( *levels.back() );
+
+    --howmanylevels;
+    while ( (1<<(howmanylevels))-1 >= 2*teamspec.num_units(0) &&
+            (1<<(howmanylevels))-1 >= 2*teamspec.num_units(1) &&
+            (1<<(howmanylevels))-1 >= 2*teamspec.num_units(2) ) {
+
+        Level& previouslevel= *levels.back();
+
+        levels.push_back(
+            level_pool.acquire( previouslevel,
+                       (1<<(howmanylevels))-1,
+                       (1<<(howmanylevels))-1,
+                       (1<<(howmanylevels))-1,
+                       dash::Team::All(), teamspec ) );
+
+        initboundary_zero( *levels.back() );
+
+        dash::barrier();
+        --howmanylevels;
+    }
+
+    Level& corr= *levels.front();
+
+    MatrixT p( Level::SizeSpecT( n, n, n ),
+        Level::DistSpecT( dash::BLOCKED, dash::BLOCKED, dash::BLOCKED ), dash::Team::All(), teamspec );
+    MatrixT s( Level::SizeSpecT( n, n, n ),
+        Level::DistSpecT( dash::BLOCKED, dash::BLOCKED, dash::BLOCKED ), dash::Team::All(), teamspec );
+    MatrixT w( Level::SizeSpecT( n, n, n ),
+        Level::DistSpecT( dash::BLOCKED, dash::BLOCKED, dash::BLOCKED ), dash::Team::All(), teamspec );
+
+    size_t nl= fine.src_grid->local_size();
+    double* px= fine.src_grid->lbegin();
+    const double* pf= fine.rhs_grid->lbegin();
+    double* pr= corr.rhs_grid->lbegin();
+    double* pp= p.lbegin();
+    double* ps= s.lbegin();
+    double* pw= w.lbegin();
+
+    /* r= ff*f - A x */
+    apply_operator( fine, w );
+#pragma omp parallel for schedule(static)
+    for ( size_t i= 0; i < nl; ++i ) {
+        pr[i]= fine.ff * pf[i] - pw[i];
+    }
+    corr.rhs_dirty= true;
+
+    writeToCsv( fine );
+
+    Allreduce res( dash::Team::All() );
+    AllreduceSumAsync dots;
+
+    minimon.stop( "setup", dash::Team::All().size() );
+
+    // mgcg
+    minimon.start();
+
+    /* the preconditioner is applied quietly and to a fixed number of sweeps */
+    cycle_output= false;
+    full_weighting= true;
+    jacobi_weight= 6.0 / 7.0;
+    double eps_inner= 1.0e-3 * eps;
+
+    double gamma_old= 1.0;
+    double alpha_old= 1.0;
+    double ps_old= 1.0; /* (p,s) */
+    double rms= 0.0;
+    uint32_t k= 0;
+    while ( k < 1000 ) {
+
+        /* z= M r with one V-cycle from z= 0. The smoothers swap src_grid and
+        dst_grid of corr, so z is wherever src_grid points after the cycle */
+        std::fill( corr.src_grid->lbegin(), corr.src_grid->lbegin() + nl, 0.0 );
+        corr.smoother_step= 0;
+        recursive_cycle( levels.begin(), levels.end(), mgcg_sweeps, 1, eps_inner, res );
+        const double* pz= corr.src_grid->lbegin();
+
+        double local[3]= { local_dot( *corr.rhs_grid, *corr.src_grid ),
+            local_dot( *corr.rhs_grid, *corr.rhs_grid ),
+            ( 0 == k ) ? 0.0 : local_dot( *corr.src_grid, s ) };
+        dots.start( local, 3 );
+
+        apply_operator( corr, w );
+
+        const double* global= dots.finish();
+        double gamma= global[0];
+        double zeta= global[2];
+        rms= std::fabs( fine.m ) * std::sqrt( global[1] / ( n*n*n ) );
+
+        if ( 0 == dash::myid() ) {
+            cout << "mgcg iteration " << k << " residual " << rms << endl;
+        }
+        if ( rms <= eps ) break;
+
+        double delta= local_dot( *corr.src_grid, w );
+        dots.start( &delta, 1 );
+
+        double beta= ( 0 == k ) ? 0.0 : -alpha_old * zeta / gamma_old;
+#pragma omp parallel for schedule(static)
+        for ( size_t i= 0; i < nl; ++i ) {
+            pp[i]= pz[i] + beta * pp[i];
+            ps[i]= pw[i] + beta * ps[i];
+        }
+
+        delta= dots.finish()[0];
+        double pdots= delta + 2.0 * beta * zeta + beta * beta * ps_old;
+        double alpha= gamma / pdots;
+
+#pragma omp parallel for schedule(static)
+        for ( size_t i= 0; i < nl; ++i ) {
+            px[i] += alpha * pp[i];
+            pr[i] -= alpha * ps[i];
+        }
+        corr.rhs_dirty= true;
+
+        gamma_old= gamma;
+        alpha_old= alpha;
+        ps_old= pdots;
+        ++k;
+    }
+
+    cycle_output= true;
+    full_weighting= false;
+    jacobi_weight= 1.0;
+    fine.src_grid->barrier();
+
+    minimon.stop( "mgcg", dash::Team::All().size(), nl );
 
     if ( 0 == dash::myid() ) {
+        cout << "mgcg: " << k << " iterations with residual " << rms << endl;
+    }
 
-        cout << "run multigrid iteration with " << dash::Team::All().size() << " units "
-            "for with grids from " <<
-            2 << "×" <<
-            2 << "×" <<
-            2 <<
-            " to " <<
+    writeToCsv( fine );
+
+    if ( 0 == dash::myid() ) {
+
+        if ( ! check_symmetry( *fine.src_grid, eps ) ) {
+
+            cout << "test for asymmetry of soution failed!" << endl;
+        }
+    }
+
+    for ( Level* l : levels ) {
+        level_pool.release( l );
+    }
+    level_pool.release( &fine );
+}
+
+
+#ifdef USE_NEW_SCALEUP
+
+/**
+Multigrid iteration in mixed precision. The finest level holds the solution and
+computes the residual in double, all coarser levels only hold corrections and use
+float, which halves their memory traffic and halo volume. The restriction to the
+first coarse level and the prolongation back convert between both types.
+
+Float has a relative precision of about 1e-7, so the coarse levels only solve to a
+tolerance relative to the current residual of the finest level. Instead, the cycles
+are repeated until the residual on the finest level is below eps, like in iterative
+refinement.
+
+Works only with all levels on the same team, i.e., not in elastic mode, and only
+with the new scaleup, the old one is not a template for both element types. The
+float levels are not from the level pool, which holds double levels only. Their
+smoother uses the portable loop of StencilKernel7 with the arithmetic in double.
+*/
+void do_multigrid_mixed( uint32_t howmanylevels, double eps, std::array< double, 3 >& dim ) {
+    SCOREP_USER_FUNC()
+
+    // setup
+    minimon.start();
+
+    TeamSpecT teamspec( dash::Team::All().size(), 1, 1 );
+    teamspec.balance_extents();
+
+    if ( 0 == dash::myid() ) {
+
+        cout << "run mixed precision multigrid iteration with " << dash::Team::All().size() << " units "
+            "with double on the finest grid " <<
             ((1<<(howmanylevels))-1) << "×" <<
             ((1<<(howmanylevels))-1) << "×" <<
             ((1<<(howmanylevels))-1) <<
-            endl;
+            " and float on all coarser grids" << endl;
     }
 
-    /* finest grid needs to be larger than 2*teamspec per dimension,
-    that means local grid is >= 2 elements */
     assert( (1<<(howmanylevels))-1 >= 2*teamspec.num_units(0) );
     assert( (1<<(howmanylevels))-1 >= 2*teamspec.num_units(1) );
     assert( (1<<(howmanylevels))-1 >= 2*teamspec.num_units(2) );
 
-    /* create all grid levels, starting with the finest and ending with 2x2,
-    The finest level is outside the loop because it is always done by dash::Team::All() */
-
-    if ( 0 == dash::myid() ) {
-        cout << "finest level is " <<
-            (1<<(howmanylevels))-1 << "×" <<
-            (1<<(howmanylevels))-1 << "×" <<
-            (1<<(howmanylevels))-1 <<
-            " distributed over " <<
-            teamspec.num_units(0) << "×" <<
-            teamspec.num_units(1) << "×" <<
-            teamspec.num_units(2) << " units" << endl;
-    }
-
-    levels.push_back( new Level( dim[0], dim[1], dim[2],
+    Level* finest= level_pool.acquire( dim[0], dim[1], dim[2],
         (1<<(howmanylevels))-1,
         (1<<(howmanylevels))-1,
         (1<<(howmanylevels))-1,
-        dash::Team::All(), teamspec ) );
+        dash::Team::All(), teamspec );
 
-    /* only do initgrid on the finest level, use scaledownboundary for all others */
-    initboundary( *levels.back() );
+    initboundary( *finest );
 
     dash::barrier();
 
+    /* the float levels are owned here, 'levels' is the view for the cycles */
+    vector< std::unique_ptr<LevelF> > owned;
+    vector<LevelF*> levels;
+    levels.reserve( howmanylevels );
+
     --howmanylevels;
     while ( (1<<(howmanylevels))-1 >= 2*teamspec.num_units(0) &&
             (1<<(howmanylevels))-1 >= 2*teamspec.num_units(1) &&
             (1<<(howmanylevels))-1 >= 2*teamspec.num_units(2) ) {
 
-        /*
+        if ( levels.empty() ) {
+
+            owned.emplace_back( new LevelF( *finest,
+                (1<<(howmanylevels))-1,
+                (1<<(howmanylevels))-1,
+                (1<<(howmanylevels))-1,
+                dash::Team::All(), teamspec ) );
+        } else {
+
+            owned.emplace_back( new LevelF( *levels.back(),
+                (1<<(howmanylevels))-1,
+                (1<<(howmanylevels))-1,
+                (1<<(howmanylevels))-1,
+                dash::Team::All(), teamspec ) );
+        }
+        levels.push_back( owned.back().get() );
+
+        initboundary_zero( *levels.back() );
+
+        dash::barrier();
+        --howmanylevels;
+    }
+
+    /* the finest grid alone is not a multigrid hierarchy */
+    assert( ! levels.empty() );
+
+    initgrid( *finest );
+    writeToCsv( *finest );
+
+    dash::Team::All().barrier();
+
+    Allreduce res( dash::Team::All() );
+
+    minimon.stop( "setup", dash::Team::All().size() );
+
+    const uint32_t beta= 20;
+    const uint32_t maxcycles= 50;
+
+    double finestres= res.get();
+    for ( uint32_t c= 0; c < maxcycles; ++c ) {
+
+        // mixed_cycle
+        minimon.start();
+
+        /* smoothen the solution in double */
+        uint32_t j= 0;
+        res.reset( finest->src_grid->team() );
+        while ( res.get() > eps && j < beta ) {
+
+            smoothen_selected( *finest, res );
+            j += finest->halo_depth;
+        }
+        finestres= res.get();
         if ( 0 == dash::myid() ) {
-            cout << "compute level " << l << " is " <<
-                (1<<(howmanylevels))-1 << "×" <<
-                (1<<(howmanylevels))-1 << "×" <<
-                (1<<(howmanylevels))-1 <<
-                " distributed over " <<
-                teamspec.num_units(0) << "×" <<
-                teamspec.num_units(1) << "×" <<
-                teamspec.num_units(2) << " units" << endl;
+            cout << "mixed cycle " << c << ": smoothing finest " << j <<
+                " times with residual " << finestres << endl;
         }
-        */
+        if ( finestres <= eps ) {
 
-        /* do not try to allocate >= 8GB per core -- try to prevent myself
-        from running too big a simulation on my laptop */
-        assert( ((1<<(howmanylevels))-1) *
-            ((1<<(howmanylevels))-1) *
-            ((1<<(howmanylevels))-1) < dash::Team::All().size() * (1<<27) );
+            minimon.stop( "mixed_cycle", dash::Team::All().size() );
+            break;
+        }
 
-        Level& previouslevel= *levels.back();
+        /* double residual ⇒ float right hand side of the correction equation */
+        scaledown( *finest, *levels.front() );
 
-        levels.push_back(
-            new Level( previouslevel,
-                       (1<<(howmanylevels))-1,
-                       (1<<(howmanylevels))-1,
-                       (1<<(howmanylevels))-1,
-                       dash::Team::All(), teamspec ) );
+        recursive_cycle( levels.begin(), levels.end(), beta, cycle_gamma,
+            std::max( eps, 1.0e-4 * finestres ), res, cycle_f );
 
-        /* scaledown boundary instead of initializing it from the same
-        procedure, because this is very prone to subtle mistakes which
-        makes the entire multigrid algorithm misbehave. */
-        //scaledownboundary( previouslevel, *levels.back() );
+        /* float correction ⇒ added to the double solution */
+        scaleup( *levels.front(), *finest );
+        writeToCsv( *finest );
 
-        initboundary_zero( *levels.back() );
+        minimon.stop( "mixed_cycle", dash::Team::All().size() );
+    }
 
-        dash::barrier();
-        --howmanylevels;
+    dash::Team::All().barrier();
+
+    if ( 0 == dash::myid()  ) {
+        cout << "final smoothing with res " << eps << endl;
     }
+    smoothen_final( *finest, eps, res );
+    writeToCsv( *finest );
 
-    /* here all units and all teams meet again, those that were active for the coarsest
-    levels and those that were dormant */
     dash::Team::All().barrier();
 
-    /* Fill finest level. Strictly, we don't need to set any initial values here
-    but we do it for demonstration in the graphical output */
-    initgrid( *levels.front() );
-    //markunits( *levels.front()->src_grid );
+    if ( 0 == dash::myid() ) {
+
+        if ( ! check_symmetry( *finest->src_grid, eps ) ) {
+
+            cout << "test for asymmetry of soution failed!" << endl;
+        }
+    }
+
+    /* collectively from the coarsest to the finest float level */
+    levels.clear();
+    while ( ! owned.empty() ) {
+        owned.pop_back();
+    }
+    level_pool.release( finest );
+}
+
+#endif /* USE_NEW_SCALEUP */
+
+
+/* is a grid of (2^h -1)^3 inner points large enough for a team of p units,
+that is at least 2 points per unit and dimension? */
+bool level_fits_team( uint32_t h, uint32_t p ) {
+
+    TeamSpecT teamspec( p, 1, 1 );
+    teamspec.balance_extents();
+
+    size_t n= (1<<h)-1;
+    return n >= 2*teamspec.num_units(0) &&
+        n >= 2*teamspec.num_units(1) &&
+        n >= 2*teamspec.num_units(2);
+}
+
+
+/**
+Cost model for the automatic team agglomeration in elastic mode, i.e., '-e0' or
+'--elastic=auto'. Returns the team size for the grid levels 2^h -1 with
+h= howmanylevels-1 down to 2, in that order, as used in the construction loop
+of do_multigrid_elastic().
+
+First, a few Jacobi steps are timed on every level with all units, separated into
+computation (minimon regions smoothen_inner and smoothen_outer) and communication
+(smoothen_wait, smoothen_collect, and smoothen_wait_res). Levels too small for all
+units are extrapolated from the smallest measured one. Its communication time is
+taken as the latency part, the rest of the communication time of larger levels
+as the part proportional to the halo surface. A smoothing step on level h with p
+instead of all P units is then predicted as
+
+    comp(h) * P/p + lat * log2(2p)/log2(2P) + vol(h) * (P/p)^(2/3)
+
+and a transfer to a smaller team as two steps of the larger team. A dynamic
+program over the levels chooses the team size per level among all divisors of the
+previous team size, weighting every level with its number of visits per cycle.
+
+Unit 0 decides with the maximum times over all units and distributes the result,
+so that all units build the same hierarchy of teams.
+*/
+vector<uint32_t> plan_elastic_teams( uint32_t howmanylevels, std::array< double, 3 >& dim ) {
+    SCOREP_USER_FUNC()
+
+    // plan_elastic
+    minimon.start();
+
+    const uint32_t P= dash::Team::All().size();
+    const uint32_t H= howmanylevels;
+    const uint32_t steps= 4;
+
+    /* comp[h] and comm[h] per smoothing step with all units */
+    vector<double> comp( H+1, 0.0 );
+    vector<double> comm( H+1, 0.0 );
+
+    /* measure the plain Jacobi smoother without temporal blocking and without
+    '--faces', which has the separate minimon regions for computation and
+    communication */
+    uint32_t saved_depth= blocking_depth;
+    blocking_depth= 1;
+    bool saved_faces= per_face_halo;
+    per_face_halo= false;
+
+    TeamSpecT teamspec( P, 1, 1 );
+    teamspec.balance_extents();
+
+    Allreduce res( dash::Team::All() );
+    for ( uint32_t h= H-1; h >= 2 && level_fits_team( h, P ); --h ) {
+
+        Level& level= *level_pool.acquire( dim[0], dim[1], dim[2], (1<<h)-1, (1<<h)-1, (1<<h)-1,
+            dash::Team::All(), teamspec );
+        initboundary_zero( level );
+        initgrid( level );
+
+        res.reset( dash::Team::All() );
+        smoothen( level, res ); /* warm up */
+
+        double c0= minimon.runtime_sum( "smoothen_inner" ) + minimon.runtime_sum( "smoothen_outer" );
+        double w0= minimon.runtime_sum( "smoothen_wait" ) + minimon.runtime_sum( "smoothen_collect" ) +
+            minimon.runtime_sum( "smoothen_wait_res" );
+        for ( uint32_t i= 0; i < steps; ++i ) {
+            smoothen( level, res );
+        }
+        double c1= minimon.runtime_sum( "smoothen_inner" ) + minimon.runtime_sum( "smoothen_outer" );
+        double w1= minimon.runtime_sum( "smoothen_wait" ) + minimon.runtime_sum( "smoothen_collect" ) +
+            minimon.runtime_sum( "smoothen_wait_res" );
+
+        comp[h]= ( c1 - c0 ) / steps;
+        comm[h]= ( w1 - w0 ) / steps;
+
+        /* the elastic setup afterwards gets the levels for dash::Team::All() from the pool */
+        level_pool.release( &level );
+    }
+
+    blocking_depth= saved_depth;
+    per_face_halo= saved_faces;
+
+    /* maximum over all units, every unit contributes comp and comm for all levels */
+    dash::Array<double> measured( 2*(H+1)*P );
+    std::copy( comp.begin(), comp.end(), measured.lbegin() );
+    std::copy( comm.begin(), comm.end(), measured.lbegin() + (H+1) );
+    measured.barrier();
+
+    dash::Array<uint32_t> shared_plan( H+1 );
+
+    if ( 0 == dash::myid() ) {
+
+        vector<double> all( 2*(H+1)*P );
+        dash::copy( measured.begin(), measured.end(), all.data() );
+        for ( uint32_t u= 1; u < P; ++u ) {
+            for ( uint32_t h= 0; h <= H; ++h ) {
+                comp[h]= std::max( comp[h], all[ 2*(H+1)*u + h ] );
+                comm[h]= std::max( comm[h], all[ 2*(H+1)*u + (H+1) + h ] );
+            }
+        }
+
+        /* the smallest measured level, if none then no level below the finest
+        fits all units and the relative costs do not matter much */
+        uint32_t hm= H-1;
+        while ( hm >= 2 && level_fits_team( hm, P ) ) --hm;
+        ++hm;
+        if ( hm > H-1 ) {
+            hm= H-1;
+            comp[hm]= 1.0;
+            comm[hm]= 1.0;
+        }
+
+        auto points= []( uint32_t h ) { return std::pow( (double) ( (1<<h)-1 ), 3 ); };
+
+        /* latency and volume part of the communication, extrapolate all other levels */
+        double lat= comm[hm];
+        vector<double> vol( H+1, 0.0 );
+        for ( uint32_t h= hm; h <= H-1; ++h ) {
+            vol[h]= std::max( 0.0, comm[h] - lat );
+        }
+        comp[H]= comp[H-1] * points( H ) / points( H-1 );
+        vol[H]= vol[H-1] * std::pow( points( H ) / points( H-1 ), 2.0/3.0 );
+        for ( uint32_t h= 2; h < hm; ++h ) {
+            comp[h]= comp[hm] * points( h ) / points( hm );
+            vol[h]= vol[hm] * std::pow( points( h ) / points( hm ), 2.0/3.0 );
+        }
+
+        auto step= [&]( uint32_t h, uint32_t p ) {
+            return comp[h] * P / p + lat * std::log2( 2.0*p ) / std::log2( 2.0*P ) +
+                vol[h] * std::pow( (double) P / p, 2.0/3.0 );
+        };
 
-    writeToCsv( *levels.front() );
+        /* level h is visited gamma^(H-h) times per cycle, F-cycles visit it H-h+1 times */
+        auto visits= [&]( uint32_t h ) {
+            return cycle_f ? (double) ( H-h+1 ) : std::pow( (double) cycle_gamma, (double) ( H-h ) );
+        };
 
-    dash::Team::All().barrier();
+        vector<uint32_t> divisors;
+        for ( uint32_t d= 1; d <= P; ++d ) {
+            if ( 0 == P % d ) divisors.push_back( d );
+        }
+        size_t nd= divisors.size();
 
-    Allreduce res( dash::Team::All() );
+        /* The construction loop iteration for h with team size p creates level h on
+        p units, and if the team shrinks, also a copy of level h+1 on p units which
+        then does the smoothing of level h+1. So the team size chosen for h computes
+        level h+1 (and also level 2 for h == 2) and pays for the transfer of level h+1.
+        best[h][i] is the cost of levels H .. h+1 with team size divisors[i] at h. */
+        const double inf= 1.0e300;
+        vector< vector<double> > best( H+1, vector<double>( nd, inf ) );
+        vector< vector<size_t> > from( H+1, vector<size_t>( nd, nd-1 ) );
 
-    minimon.stop( "setup", dash::Team::All().size() );
+        for ( uint32_t h= H-1; h >= 2; --h ) {
+            for ( size_t i= 0; i < nd; ++i ) {
 
-    //v_cycle( levels.begin(), levels.end(), 20, eps, res );
-    //recursive_cycle( levels.begin(), levels.end(), 20, 1 /* 1 for v cycle */, eps, res );
+                uint32_t p= divisors[i];
+                if ( ! level_fits_team( h, p ) ) continue;
 
-    if ( 0 == dash::myid()  ) {
-        cout << "start w-cycle with res " << eps << endl << endl;
-    }
-    //w_cycle( levels.begin(), levels.end(), 20, eps, res );
-    recursive_cycle( levels.begin(), levels.end(), 20, 2 /* 2 for w cycle */, eps, res );
-    dash::Team::All().barrier();
+                double own= visits( h+1 ) * step( h+1, p ) +
+                    ( ( 2 == h ) ? visits( h ) * step( h, p ) : 0.0 );
 
+                for ( size_t k= 0; k < nd; ++k ) {
 
-    if ( 0 == dash::myid()  ) {
-        cout << "final smoothing with res " << eps << endl;
-    }
-    smoothen_final( *levels.front(), eps, res );
-    writeToCsv( *levels.front() );
+                    uint32_t q= divisors[k];
+                    double before= ( H-1 == h ) ? ( ( P == q ) ? 0.0 : inf ) : best[h+1][k];
+                    if ( inf <= before || 0 != q % p ) continue;
 
-    dash::Team::All().barrier();
+                    double cost= before + own + ( ( p < q ) ? visits( h+1 ) * 2.0 * step( h+1, q ) : 0.0 );
+                    if ( cost < best[h][i] ) {
+                        best[h][i]= cost;
+                        from[h][i]= k;
+                    }
+                }
+            }
+        }
 
-    if ( 0 == dash::myid() ) {
+        size_t i= std::min_element( best[2].begin(), best[2].end() ) - best[2].begin();
+        for ( uint32_t h= 2; h <= H-1; ++h ) {
 
-        if ( ! check_symmetry( *levels.front()->src_grid, eps ) ) {
+            shared_plan[h]= divisors[i];
+            i= from[h][i];
+        }
 
-            cout << "test for asymmetry of soution failed!" << endl;
+        cout << "automatic team agglomeration with predicted time per smoothing step:" << endl;
+        for ( uint32_t h= H-1; h >= 2; --h ) {
+            uint32_t p= shared_plan[h];
+            cout << "    " << ((1<<(h+1))-1) << "³ on " << p << " units: " << step( h+1, p ) << " s" <<
+                ( level_fits_team( h+1, P ) ? " instead of " + std::to_string( step( h+1, P ) ) + " s" : std::string() ) << endl;
         }
     }
+    shared_plan.barrier();
+
+    vector<uint32_t> plan;
+    for ( uint32_t h= H-1; h >= 2; --h ) {
+        plan.push_back( shared_plan[h] );
+    }
+
+    minimon.stop( "plan_elastic", P );
+
+    return plan;
 }
 
 
-/* elastic mode runs but still seems to have errors in it */
+/* elastic mode runs but still seems to have errors in it,
+split == 0 selects the team sizes with plan_elastic_teams() */
 void do_multigrid_elastic( uint32_t howmanylevels, double eps, std::array< double, 3 >& dim, int split ) {
 
     // setup
@@ -3174,10 +5550,17 @@ void do_multigrid_elastic( uint32_t howmanylevels, double eps, std::array< doubl
             ((1<<(howmanylevels))-1)*factor_z << "×" <<
             ((1<<(howmanylevels))-1)*factor_y << "×" <<
             ((1<<(howmanylevels))-1)*factor_x <<
-            " splitting every " << split << (split == 1 ? "st" : split == 2 ? "nd" : split == 3 ? "rd" : "th") << " level" <<
+            ( ( 0 == split ) ? std::string( " with automatic team sizes" ) : " splitting every " + std::to_string( split ) +
+                (split == 1 ? "st" : split == 2 ? "nd" : split == 3 ? "rd" : "th") + " level" ) <<
             endl << endl;
     }
 
+    /* team size per construction step from the cost model */
+    vector<uint32_t> plan;
+    if ( 0 == split ) {
+        plan= plan_elastic_teams( howmanylevels, dim );
+    }
+
     /* create all grid levels, starting with the finest and ending with 2x2,
     The finest level is outside the loop because it is always done by dash::Team::All() */
 
@@ -3192,7 +5575,7 @@ void do_multigrid_elastic( uint32_t howmanylevels, double eps, std::array< doubl
             teamspec.num_units(2) << " units" << endl;
     }
 
-    levels.push_back( new Level( dim[0], dim[1], dim[2],
+    levels.push_back( level_pool.acquire( dim[0], dim[1], dim[2],
         ((1<<(howmanylevels))-1)*factor_z ,
         ((1<<(howmanylevels))-1)*factor_y ,
         ((1<<(howmanylevels))-1)*factor_x ,
@@ -3208,7 +5591,18 @@ void do_multigrid_elastic( uint32_t howmanylevels, double eps, std::array< doubl
     while ( 0 < howmanylevels ) {
 
         dash::Team& previousteam= levels.back()->src_grid->team();
-        dash::Team& currentteam= ( split_steps++ % split == 0 && previousteam.size() > 1 ) ? previousteam.split(8) : previousteam;
+
+        /* by how many subteams to split the previous one */
+        uint32_t parts= 1;
+        if ( 0 == split ) {
+            if ( split_steps <= (int) plan.size() ) {
+                parts= previousteam.size() / plan[split_steps-1];
+            }
+            split_steps++;
+        } else if ( split_steps++ % split == 0 && previousteam.size() > 1 ) {
+            parts= 8;
+        }
+        dash::Team& currentteam= ( 1 < parts ) ? previousteam.split( parts ) : previousteam;
         TeamSpecT localteamspec( currentteam.size(), 1, 1 );
         localteamspec.balance_extents();
 
@@ -3241,7 +5635,7 @@ void do_multigrid_elastic( uint32_t howmanylevels, double eps, std::array< doubl
                 */
 
                 levels.push_back(
-                    new Level( *levels.back(),
+                    level_pool.acquire( *levels.back(),
                                ((1<<(howmanylevels+1))-1)*factor_z,
                                ((1<<(howmanylevels+1))-1)*factor_y,
                                ((1<<(howmanylevels+1))-1)*factor_x,
@@ -3271,7 +5665,7 @@ void do_multigrid_elastic( uint32_t howmanylevels, double eps, std::array< doubl
                     ((1<<(howmanylevels))-1)*factor_x < currentteam.size() * (1<<27) );
 
             levels.push_back(
-                new Level( *levels.back(),
+                level_pool.acquire( *levels.back(),
                            ((1<<(howmanylevels))-1)*factor_z ,
                            ((1<<(howmanylevels))-1)*factor_y ,
                            ((1<<(howmanylevels))-1)*factor_x ,
@@ -3298,6 +5692,10 @@ void do_multigrid_elastic( uint32_t howmanylevels, double eps, std::array< doubl
     levels and those that were dormant */
     dash::Team::All().barrier();
 
+    /* free the levels of the team size planning that the hierarchy did not
+    reuse, e.g., all of them with '--tb' because of their different halo depth */
+    level_pool.clear();
+
     /* Fill finest level. Strictly, we don't need to set any initial values here
     but we do it for demonstration in the graphical output */
     initgrid( *levels.front() );
@@ -3326,10 +5724,10 @@ void do_multigrid_elastic( uint32_t howmanylevels, double eps, std::array< doubl
 */
 
     if ( 0 == dash::myid()  ) {
-        cout << "start w-cycle with res " << eps << endl;
+        cout << "start cycle with res " << eps << endl;
     }
     //v_cycle( levels.begin(), levels.end(), 20, eps, res );
-    recursive_cycle( levels.begin(), levels.end(), 20, 2 /* 2 for w cycle */, eps, res );
+    recursive_cycle( levels.begin(), levels.end(), 20, cycle_gamma /* 1 for v cycle, 2 for w cycle */, eps, res, cycle_f );
 
     dash::Team::All().barrier();
 
@@ -3348,117 +5746,575 @@ void do_multigrid_elastic( uint32_t howmanylevels, double eps, std::array< doubl
             cout << "test for asymmetry of soution failed!" << endl;
         }
     }
+
+    for ( Level* l : levels ) {
+        level_pool.release( l );
+    }
+}
+
+
+/* Header of a checkpoint file, followed by the inner grid points of the
+src_grid in global row-major order as doubles. The layout does not depend on
+the distribution, so a restart may use a different number of units. */
+struct CheckpointHeader {
+
+    char magic[8];
+    uint64_t d, h, w;
+    double time, timenext;
+    uint64_t j;
+    uint32_t filenumber, snapshotnumber;
+};
+
+const char checkpoint_magic[8]= { 'M', 'G', '3', 'D', 'C', 'K', 'P', '1' };
+
+
+/* Call f( local offset, file offset in elements, length ) for all rows of the local
+block of the grid. Rows that are contiguous both locally and in the file, i.e.,
+if the block has the full width (and height), are merged into one call. */
+template< typename F >
+void for_checkpoint_rows( const MatrixT& grid, F f ) {
+
+    std::array< long int, 3 > corner= grid.pattern().global( {0,0,0} );
+    size_t h= grid.extent(1);
+    size_t w= grid.extent(2);
+    size_t dl= grid.local.extent(0);
+    size_t hl= grid.local.extent(1);
+    size_t wl= grid.local.extent(2);
+
+    size_t runlocal= 0;
+    size_t runoffset= 0;
+    size_t runlen= 0;
+    for ( size_t z= 0; z < dl; ++z ) {
+        for ( size_t y= 0; y < hl; ++y ) {
+
+            size_t local= ( z * hl + y ) * wl;
+            size_t offset= ( ( corner[0] + z ) * h + corner[1] + y ) * w + corner[2];
+            if ( 0 < runlen && runlocal + runlen == local && runoffset + runlen == offset ) {
+                runlen += wl;
+                continue;
+            }
+            if ( 0 < runlen ) {
+                f( runlocal, runoffset, runlen );
+            }
+            runlocal= local;
+            runoffset= offset;
+            runlen= wl;
+        }
+    }
+    if ( 0 < runlen ) {
+        f( runlocal, runoffset, runlen );
+    }
+}
+
+
+/* true on all units of the team if ok is true on all of them */
+bool all_units_ok( dash::Team& team, bool ok ) {
+
+    int local= ok ? 1 : 0;
+    int global= 0;
+    dart_allreduce( &local, &global, 1, DART_TYPE_INT, DART_OP_MIN, team.dart_id() );
+
+    return 1 == global;
+}
+
+
+/* Write the src_grid of the level and the state of the simulation loop to one
+shared binary file. Every unit writes its rows directly at their offsets. The
+file is written under a temporary name first and renamed by unit 0 at the end
+only if all units wrote their parts, so an interrupted or failed checkpoint
+never replaces the previous one.
+Needs to be called by all units of the level's team. */
+void writeCheckpoint( const Level& level, double time, double timenext, uint64_t j,
+        const std::string& filename ) {
+
+    SCOREP_USER_FUNC()
+
+    const MatrixT& grid= *level.src_grid;
+    std::string tmpname= filename + ".tmp";
+
+    // checkpoint
+    minimon.start();
+
+    bool headerok= true;
+    if ( 0 == grid.team().myid() ) {
+
+        CheckpointHeader header;
+        memcpy( header.magic, checkpoint_magic, sizeof(header.magic) );
+        header.d= grid.extent(0);
+        header.h= grid.extent(1);
+        header.w= grid.extent(2);
+        header.time= time;
+        header.timenext= timenext;
+        header.j= j;
+#ifdef WITHCSVOUTPUT
+        header.filenumber= (uint32_t) filenumber->get();
+#else /* WITHCSVOUTPUT */
+        header.filenumber= 0;
+#endif /* WITHCSVOUTPUT */
+#ifdef WITHHDF5OUTPUT
+        header.snapshotnumber= snapshotnumber;
+#else /* WITHHDF5OUTPUT */
+        header.snapshotnumber= 0;
+#endif /* WITHHDF5OUTPUT */
+
+        int fd= open( tmpname.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644 );
+        if ( 0 > fd || (ssize_t) sizeof(header) != pwrite( fd, &header, sizeof(header), 0 ) ) {
+            cerr << "cannot write checkpoint file " << tmpname << endl;
+            headerok= false;
+        }
+        if ( 0 <= fd ) close( fd );
+    }
+    grid.barrier();
+
+    int fd= open( tmpname.c_str(), O_WRONLY );
+    const double* p= grid.lbegin();
+    bool ok= headerok && ( 0 <= fd );
+    for_checkpoint_rows( grid, [&]( size_t local, size_t offset, size_t len ) {
+
+        ok= ok && (ssize_t) ( len * sizeof(double) ) == pwrite( fd, p + local, len * sizeof(double),
+            sizeof(CheckpointHeader) + offset * sizeof(double) );
+    } );
+    if ( 0 <= fd ) {
+        ok= ( 0 == fsync( fd ) ) && ok;
+        close( fd );
+    }
+    if ( ! ok ) {
+        cerr << "unit " << dash::myid() << " failed to write its part of checkpoint " << tmpname << endl;
+    }
+
+    /* also the barrier before the rename */
+    bool allok= all_units_ok( grid.team(), ok );
+
+    if ( 0 == grid.team().myid() ) {
+
+        if ( allok ) {
+            rename( tmpname.c_str(), filename.c_str() );
+            cout << "wrote checkpoint " << filename << " at t= " << time << endl;
+        } else {
+            cerr << "checkpoint " << tmpname << " incomplete, kept previous " << filename << endl;
+        }
+    }
+
+    minimon.stop( "checkpoint", grid.team().size(), grid.local_size() );
+}
+
+
+/* Read the src_grid of the level and the state of the simulation loop back from
+a checkpoint, the grid size must match but not the number of units.
+Returns false on all units if the file does not fit or any unit fails to read
+its part. Needs to be called by all units of the level's team. */
+bool readCheckpoint( Level& level, double& time, double& timenext, uint64_t& j,
+        const std::string& filename ) {
+
+    SCOREP_USER_FUNC()
+
+    MatrixT& grid= *level.src_grid;
+
+    CheckpointHeader header;
+    int fd= open( filename.c_str(), O_RDONLY );
+    bool headerok= ! ( 0 > fd || (ssize_t) sizeof(header) != pread( fd, &header, sizeof(header), 0 ) ||
+            0 != memcmp( header.magic, checkpoint_magic, sizeof(header.magic) ) ||
+            header.d != grid.extent(0) || header.h != grid.extent(1) || header.w != grid.extent(2) );
+    if ( ! all_units_ok( grid.team(), headerok ) ) {
+
+        if ( 0 == grid.team().myid() ) {
+            cerr << "cannot restart from " << filename <<
+                ", no checkpoint or a different grid size" << endl;
+        }
+        if ( 0 <= fd ) close( fd );
+        return false;
+    }
+
+    double* p= grid.lbegin();
+    bool ok= true;
+    for_checkpoint_rows( grid, [&]( size_t local, size_t offset, size_t len ) {
+
+        ok= ok && (ssize_t) ( len * sizeof(double) ) == pread( fd, p + local, len * sizeof(double),
+            sizeof(CheckpointHeader) + offset * sizeof(double) );
+    } );
+    close( fd );
+    if ( ! all_units_ok( grid.team(), ok ) ) {
+
+        if ( ! ok ) {
+            cerr << "unit " << dash::myid() << " failed to read its part of checkpoint " << filename << endl;
+        }
+
+        /* the partially read grid is not usable, start from the initial values */
+        initgrid( level );
+        return false;
+    }
+
+    time= header.time;
+    timenext= header.timenext;
+    j= header.j;
+
+#ifdef WITHCSVOUTPUT
+    if ( 0 == grid.team().myid() ) {
+        filenumber->set( header.filenumber );
+    }
+#endif /* WITHCSVOUTPUT */
+#ifdef WITHHDF5OUTPUT
+    snapshotnumber= header.snapshotnumber;
+#endif /* WITHHDF5OUTPUT */
+
+    level.rhs_dirty= true;
+    level.smoother_step= 0;
+    grid.barrier();
+
+    if ( 0 == grid.team().myid() ) {
+        cout << "restart from " << filename << " at t= " << time << " j= " << j << endl;
+    }
+
+    return true;
 }
 
 
 void do_simulation( uint32_t howmanylevels, double timerange, double timestep,
                     std::array< double, 3 >& dim ) {
 
-    // do_simulation
+    // do_simulation
+    minimon.start();
+
+    TeamSpecT teamspec( dash::Team::All().size(), 1, 1 );
+    teamspec.balance_extents();
+
+    /* determine factors for width and height such that every unit has a power of two
+    extent in every dimension and that the area is close to a square
+    with aspect ratio \in [0,75,1,5] */
+
+    uint32_t factor_z= 1;
+    uint32_t factor_y= 1;
+    uint32_t factor_x= 1;
+
+    if ( 0 == dash::myid() ) {
+
+        cout << "run simulation with " << dash::Team::All().size() << " units "
+            "for grid of " <<
+            ((1<<(howmanylevels))-1)*factor_z << "×" <<
+            ((1<<(howmanylevels))-1)*factor_y << "×" <<
+            ((1<<(howmanylevels))-1)*factor_x <<
+            " for " << timerange << " seconds with output steps every " << timestep << " seconds " << endl;
+    }
+
+    /* physical dimensions 10m³ because it allows larger dt */
+    Level* level= level_pool.acquire( dim[0], dim[1], dim[2],
+        ((1<<(howmanylevels))-1)*factor_z ,
+        ((1<<(howmanylevels))-1)*factor_y ,
+        ((1<<(howmanylevels))-1)*factor_x ,
+        dash::Team::All(), teamspec );
+
+    dash::barrier();
+
+    initboundary( *level );
+
+    initgrid( *level );
+    // markunits( *level->src_grid );
+
+    double time= 0.0;
+    double timenext= time + timestep;
+    uint64_t j= 0;
+
+    /* continue from a checkpoint, the output of its time step is already there */
+    bool restarted= ! restart_file.empty() &&
+        readCheckpoint( *level, time, timenext, j, restart_file );
+
+    if ( ! restarted ) {
+        writeToCsv( *level );
+    }
+
+    dash::barrier();
+
+    double dt= level->max_dt();
+
+    // do_simulation_loop
+    minimon.start();
+
+    Allreduce res( dash::Team::All() );
+
+    uint32_t outputs= 0;
+
+    if ( ! restarted ) {
+        if ( 0 == dash::myid() ) { cout << "t= " << time << " j= " << j << endl; }
+        writeToCsv( *level );
+        writeSnapshot( *level, time );
+    }
+
+    while ( time < timerange ) {
+
+        while ( time + dt < timenext ) {
+
+            /* with temporal blocking do as many full time steps per halo
+            exchange as possible before the next output time */
+            uint32_t steps= 1;
+            while ( steps < level->halo_depth && time + (steps+1)*dt < timenext ) {
+                ++steps;
+            }
+
+            if ( 1 < level->halo_depth ) {
+                smoothen_blocked( *level, res, dt, steps );
+            } else {
+                smoothen( *level, res, dt );
+            }
+            j += steps;
+            time += steps*dt;
+            // if ( 0 == dash::myid() ) { cout << "t= " << time << " dt= " << dt << endl; }
+        }
+
+        double shorten= ( timenext - time ) / dt;
+        if ( 1 < level->halo_depth ) {
+            smoothen_blocked( *level, res, dt*shorten, 1 );
+        } else {
+            smoothen( *level, res, dt*shorten );
+        }
+        ++j;
+
+        time += timenext - time;
+        timenext += timestep;
+
+        if ( 0 == dash::myid() ) { cout << "t= " << time << " j= " << j << endl; }
+        writeToCsv( *level );
+        writeSnapshot( *level, time );
+
+        if ( 0 < checkpoint_every && 0 == ++outputs % checkpoint_every ) {
+            writeCheckpoint( *level, time, timenext, j, checkpoint_file );
+        }
+    }
+
+
+# if 0
+
+    while ( res.get() > eps && j < 100000 ) {
+
+        smoothen( *level, res );
+
+        if ( 0 == j % 100 ) {
+            writeToCsv( *level );
+        }
+
+        j++;
+
+        if ( 0 == dash::myid() && ( 0 == j % 100 ) ) {
+            cout << j << ": smoothen grid with residual " << res.get() << endl;
+        }
+    }
+    writeToCsv( *level );
+
+
+#endif /* 0 */
+    minimon.stop( "do_simulation_loop", dash::Team::All().size() );
+
+    minimon.stop( "do_simulation", dash::Team::All().size() );
+
+    level_pool.release( level );
+    level= NULL;
+}
+
+
+/**
+One implicit time step of length tau for du/dt = m*( ff*f - A*u ) with f= 0, the
+same equation as the explicit steps in do_simulation(). Backward Euler solves
+( I + tau*m*A ) u_new = u, i.e., ( A + sigma*I ) u_new = sigma*u with
+sigma= 1/(tau*m). Crank-Nicolson is the explicit half step u + tau/2*m*(-A*u)
+followed by a backward Euler half step, which is exactly the trapezoidal rule
+because both factors commute.
+
+The shifted system is solved with multigrid cycles until the residual on the
+finest level is below eps. The coarser levels keep the stencil of the finest one
+while scaledown() scales the residual with 4, so the shift is 4 times larger per
+level. Afterwards all levels get the original operator back and the right hand
+side is 0 again. The finest level is the first one.
+*/
+template<typename Iterator>
+void implicit_step( Iterator itbegin, Iterator itend, double tau, double eps, Allreduce& res ) {
+    SCOREP_USER_FUNC()
+
+    Level& finest= **itbegin;
+    uint32_t par= finest.src_grid->team().size();
+
+    // implicit_step
+    minimon.start();
+
+    double c= ( CRANK_NICOLSON == time_scheme ) ? 0.5*tau : tau;
+    if ( CRANK_NICOLSON == time_scheme ) {
+
+        if ( 1 < finest.halo_depth ) {
+            smoothen_blocked( finest, res, c, 1 );
+        } else {
+            smoothen( finest, res, c );
+        }
+    }
+
+    double sigma= 1.0 / ( c * finest.m );
+    double shift= sigma;
+    for ( Iterator it= itbegin; it != itend; ++it ) {
+        (*it)->set_shift( shift );
+        shift *= 4.0;
+    }
+
+    /* rhs= sigma*u, u is also the start value */
+    size_t n= finest.src_grid->local_size();
+    const double* p_src= finest.src_grid->lbegin();
+    double* p_rhs= finest.rhs_grid->lbegin();
+    double f= sigma / finest.ff;
+#pragma omp parallel for schedule(static)
+    for ( size_t i= 0; i < n; ++i ) {
+        p_rhs[i]= f * p_src[i];
+    }
+    finest.rhs_dirty= true;
+    finest.smoother_step= 0;
+    finest.src_grid->barrier();
+
+    uint32_t cycles= 0;
+    do {
+        recursive_cycle( itbegin, itend, 20, cycle_gamma, eps, res, cycle_f );
+        ++cycles;
+    } while ( res.get() > eps && cycles < 20 );
+
+    if ( 0 == dash::myid() && res.get() > eps ) {
+        cout << "implicit step did not converge after " << cycles <<
+            " cycles, residual " << res.get() << endl;
+    }
+
+    for ( Iterator it= itbegin; it != itend; ++it ) {
+        (*it)->set_shift( 0.0 );
+    }
+    std::fill( p_rhs, p_rhs + n, 0.0 );
+    finest.rhs_dirty= true;
+    finest.smoother_step= 0;
+    finest.src_grid->barrier();
+
+    minimon.stop( "implicit_step", par, n );
+}
+
+
+/**
+Simulation like do_simulation() but with implicit time steps, see implicit_step().
+The step is the output interval divided by implicit_steps, independent of the
+grid, while the explicit steps get 4 times more with every finer level.
+Works only with all levels on the same team, i.e., not in elastic mode.
+*/
+void do_simulation_implicit( uint32_t howmanylevels, double timerange, double timestep,
+                    double eps, std::array< double, 3 >& dim ) {
+    SCOREP_USER_FUNC()
+
+    // do_simulation_implicit
     minimon.start();
 
     TeamSpecT teamspec( dash::Team::All().size(), 1, 1 );
     teamspec.balance_extents();
 
-    /* determine factors for width and height such that every unit has a power of two
-    extent in every dimension and that the area is close to a square
-    with aspect ratio \in [0,75,1,5] */
+    assert( (1<<(howmanylevels))-1 >= 2*teamspec.num_units(0) );
+    assert( (1<<(howmanylevels))-1 >= 2*teamspec.num_units(1) );
+    assert( (1<<(howmanylevels))-1 >= 2*teamspec.num_units(2) );
 
-    uint32_t factor_z= 1;
-    uint32_t factor_y= 1;
-    uint32_t factor_x= 1;
+    double tau= timestep / implicit_steps;
 
     if ( 0 == dash::myid() ) {
 
-        cout << "run simulation with " << dash::Team::All().size() << " units "
-            "for grid of " <<
-            ((1<<(howmanylevels))-1)*factor_z << "×" <<
-            ((1<<(howmanylevels))-1)*factor_y << "×" <<
-            ((1<<(howmanylevels))-1)*factor_x <<
-            " for " << timerange << " seconds with output steps every " << timestep << " seconds " << endl;
+        cout << "run implicit simulation (" <<
+            ( CRANK_NICOLSON == time_scheme ? "Crank-Nicolson" : "backward Euler" ) <<
+            ") with " << dash::Team::All().size() << " units for grid of " <<
+            ((1<<(howmanylevels))-1) << "×" <<
+            ((1<<(howmanylevels))-1) << "×" <<
+            ((1<<(howmanylevels))-1) <<
+            " for " << timerange << " seconds with output steps every " << timestep <<
+            " seconds and time step " << tau << endl;
     }
 
-    /* physical dimensions 10m³ because it allows larger dt */
-    Level* level= new Level( dim[0], dim[1], dim[2],
-        ((1<<(howmanylevels))-1)*factor_z ,
-        ((1<<(howmanylevels))-1)*factor_y ,
-        ((1<<(howmanylevels))-1)*factor_x ,
-        dash::Team::All(), teamspec );
+    vector<Level*> levels;
+    levels.reserve( howmanylevels );
 
-    dash::barrier();
+    levels.push_back( level_pool.acquire( dim[0], dim[1], dim[2],
+        (1<<(howmanylevels))-1,
+        (1<<(howmanylevels))-1,
+        (1<<(howmanylevels))-1,
+        dash::Team::All(), teamspec ) );
 
-    initboundary( *level );
+    initboundary( *levels.back() );
 
-    initgrid( *level );
-    // markunits( *level->src_grid );
+    dash::barrier();
 
-    writeToCsv( *level );
+    --howmanylevels;
+    while ( (1<<(howmanylevels))-1 >= 2*teamspec.num_units(0) &&
+            (1<<(howmanylevels))-1 >= 2*teamspec.num_units(1) &&
+            (1<<(howmanylevels))-1 >= 2*teamspec.num_units(2) ) {
 
-    dash::barrier();
+        Level& previouslevel= *levels.back();
 
-    double dt= level->max_dt();
+        levels.push_back(
+            level_pool.acquire( previouslevel,
+                       (1<<(howmanylevels))-1,
+                       (1<<(howmanylevels))-1,
+                       (1<<(howmanylevels))-1,
+                       dash::Team::All(), teamspec ) );
 
-    // do_simulation_loop
-    minimon.start();
+        initboundary_zero( *levels.back() );
 
-    Allreduce res( dash::Team::All() );
+        dash::barrier();
+        --howmanylevels;
+    }
 
+    Level& level= *levels.front();
+    initgrid( level );
 
     double time= 0.0;
     double timenext= time + timestep;
-    uint32_t j= 0;
-
-    if ( 0 == dash::myid() ) { cout << "t= " << time << " j= " << j << endl; }
-    writeToCsv( *level );
+    uint64_t j= 0;
 
-    while ( time < timerange ) {
+    /* continue from a checkpoint, the output of its time step is already there */
+    bool restarted= ! restart_file.empty() &&
+        readCheckpoint( level, time, timenext, j, restart_file );
 
-        while ( time + dt < timenext ) {
+    if ( 0 == dash::myid() ) {
+        cout << "explicit steps would use dt= " << level.dt << ", that is " <<
+            (uint64_t) std::ceil( timestep / level.dt ) << " steps per output interval instead of " <<
+            implicit_steps << endl;
+    }
 
-            smoothen( *level, res, dt );
-            ++j;
-            time += dt;
-            // if ( 0 == dash::myid() ) { cout << "t= " << time << " dt= " << dt << endl; }
-        }
+    // do_simulation_loop
+    minimon.start();
 
-        double shorten= ( timenext - time ) / dt;
-         smoothen( *level, res, dt*shorten );
-        ++j;
+    Allreduce res( dash::Team::All() );
 
-        time += timenext - time;
-        timenext += timestep;
+    uint32_t outputs= 0;
+    cycle_output= false;
 
+    if ( ! restarted ) {
         if ( 0 == dash::myid() ) { cout << "t= " << time << " j= " << j << endl; }
-        writeToCsv( *level );
+        writeToCsv( level );
+        writeSnapshot( level, time );
     }
 
+    while ( time < timerange ) {
 
-# if 0
-
-    while ( res.get() > eps && j < 100000 ) {
-
-        smoothen( *level, res );
+        for ( uint32_t s= 0; s < implicit_steps; ++s ) {
 
-        if ( 0 == j % 100 ) {
-            writeToCsv( *level );
+            implicit_step( levels.begin(), levels.end(), tau, eps, res );
+            ++j;
         }
 
-        j++;
+        time= timenext;
+        timenext += timestep;
 
-        if ( 0 == dash::myid() && ( 0 == j % 100 ) ) {
-            cout << j << ": smoothen grid with residual " << res.get() << endl;
+        if ( 0 == dash::myid() ) { cout << "t= " << time << " j= " << j << endl; }
+        writeToCsv( level );
+        writeSnapshot( level, time );
+
+        if ( 0 < checkpoint_every && 0 == ++outputs % checkpoint_every ) {
+            writeCheckpoint( level, time, timenext, j, checkpoint_file );
         }
     }
-    writeToCsv( *level );
 
+    cycle_output= true;
 
-#endif /* 0 */
     minimon.stop( "do_simulation_loop", dash::Team::All().size() );
 
-    minimon.stop( "do_simulation", dash::Team::All().size() );
+    minimon.stop( "do_simulation_implicit", dash::Team::All().size() );
 
-    delete level;
-    level= NULL;
+    for ( Level* l : levels ) {
+        level_pool.release( l );
+    }
+    levels.clear();
 }
 
 
@@ -3486,7 +6342,7 @@ void do_flat_iteration( uint32_t howmanylevels, double eps, std::array< double,
             endl;
     }
 
-    Level* level= new Level( dim[0], dim[1], dim[2],
+    Level* level= level_pool.acquire( dim[0], dim[1], dim[2],
         ((1<<(howmanylevels))-1)*factor_z ,
         ((1<<(howmanylevels))-1)*factor_y ,
         ((1<<(howmanylevels))-1)*factor_x ,
@@ -3536,7 +6392,7 @@ void do_flat_iteration( uint32_t howmanylevels, double eps, std::array< double,
         }
     }
 
-    delete level;
+    level_pool.release( level );
     level= NULL;
 }
 
@@ -3855,6 +6711,7 @@ int main( int argc, char* argv[] ) {
     auto id= dash::myid();
     minimon.stop( "dash::init", dash::Team::All().size() );
 
+
 #ifdef WITHCSVOUTPUT
     filenumber= new dash::Shared<uint32_t>();
     if ( 0 == dash::myid() ) {
@@ -3863,7 +6720,7 @@ int main( int argc, char* argv[] ) {
     filenumber->barrier();
 #endif /* WITHCSVOUTPUT */
 
-    enum { TEST, FLAT, SIM, MULTIGRID, ELASTICMULTIGRID };
+    enum { TEST, FLAT, SIM, MULTIGRID, ELASTICMULTIGRID, MGCG };
 
     int whattodo= MULTIGRID;
 
@@ -3893,14 +6750,22 @@ const char* HELPTEXT= "\n"
 " -e[<s>]|--elastic[=<s>]\n"
 "               use elastic multigrid mode, i.e., use fewer units (processes)\n"
 "               on coarser grids, <s> gives the stepping for the unit reduction\n"
-"               (default is every 3 levels a reduction of units)\n"
+"               (default is every 3 levels a reduction of units), with <s> = 0\n"
+"               or 'auto' a cost model measured at startup chooses the team sizes\n"
 " -f|--flat     run flat mode, i.e., use iterative solver on a single grid\n"
+" --mgcg [<k>]  multigrid preconditioned conjugate gradients, the preconditioner\n"
+"               is one V-cycle with k Jacobi sweeps per level and way (default 2)\n"
 " --sim <t> <s> run a simulation over time, that is also a \"flat\" solver\n"
 "               working only on a single grid. It runs t seconds simulation\n"
 "               time. The time step dt is determined by the grid and the\n"
 "               stability condition. This mode matches all time steps n*s <= t\n"
 "               exactly for the sake of a nice visualization.\n"
-"               (Visualization only active when compiled with WITHCSVOUTPUT.)\n"
+"               (Visualization only active when compiled with WITHCSVOUTPUT\n"
+"               or with WITHHDF5OUTPUT for binary snapshots.)\n"
+" --implicit <be|cn> <k>\n"
+"               in simulation mode, do k implicit time steps per output interval\n"
+"               with backward Euler or Crank-Nicolson, each solved with the\n"
+"               multigrid cycles, instead of the explicit steps\n"
 " \n"
 " Further options\n"
 "\n"
@@ -3909,14 +6774,44 @@ const char* HELPTEXT= "\n"
 " -g <n>        determine size of CSV output -- only when compiled with WITHCSVOUTPUT\n"
 "               the combined CVS output from all units (processes) will be\n"
 "               2^n +1 points in every dimension, default is n= 5 or 33^3 elements\n"
+" --cycle <c>   cycle type in multigrid mode, 'v', 'w' (default), 'f', or a\n"
+"               number gamma of recursive calls per level\n"
+" --fmg         start with a full multigrid pass in multigrid mode\n"
+" --fuse        fuse restriction and prolongation with the neighboring Jacobi\n"
+"               sweeps in the multigrid cycles\n"
+" --mixed       mixed precision in multigrid mode: double on the finest grid,\n"
+"               float for the corrections on all coarser grids\n"
+" --checkpoint <n> <file>\n"
+"               in simulation mode, write a checkpoint to <file> after every\n"
+"               n output steps\n"
+" --restart <file> resume a simulation from checkpoint <file>, the grid size\n"
+"               must match but the number of units may differ\n"
+" --asyncio <n> format and write the CSV output in a background thread with up\n"
+"               to n output steps pending -- only when compiled with WITHCSVOUTPUT\n"
 " -d <d h w>    Set physical dimensions of the simulation grid in meters\n"
 "               (default 10.0, 10.0, 10.0)\n"
+" --tb <k>      temporal blocking in the smoother: use halos of k layers and do\n"
+"               k Jacobi sweeps per halo exchange (default 1, i.e., no blocking)\n"
+" --faces       in the Jacobi smoother, wait for the face halos one by one and\n"
+"               update the border of the local block face by face\n"
+" --tile <y> <x> cache tiles of y×x points for the smoother, scaledown, and\n"
+"               scaleup, default is automatic from the size of the L2 cache\n"
+" --threads <n> number of OpenMP threads per unit, only when compiled with\n"
+"               OpenMP (see 'make multigrid3d_omp'), default from OMP_NUM_THREADS\n"
+" --stream      measure the memory bandwidth with the STREAM triad at startup\n"
+"               for the fraction of it in overview_summary.csv\n"
+" --smoother <s> smoother for the multigrid modes, one of 'jacobi' (default),\n"
+"               'rbgs' for red-black Gauss-Seidel in place, or 'cheby' for a\n"
+"               Chebyshev polynomial smoother\n"
 "\n"
 #ifdef WITHCSVOUTPUT
 " (This executable was compiled with WITHCSVOUTPUT)\n"
 #else /* WITHCSVOUTPUT */
 " (This executable was compiled without WITHCSVOUTPUT)\n"
 #endif /* WITHCSVOUTPUT */
+#ifdef WITHHDF5OUTPUT
+" (This executable was compiled with WITHHDF5OUTPUT)\n"
+#endif /* WITHHDF5OUTPUT */
 "\n\n";
 
             if ( 0 == dash::myid() ) {
@@ -3946,6 +6841,70 @@ const char* HELPTEXT= "\n"
                 cout << "run tests" << endl;
             }
 
+        } else if ( 0 == strncmp( "--cycle", argv[a], 7 ) && ( a+1 < argc ) ) {
+
+            cycle_f= false;
+            if ( 0 == strcmp( "v", argv[a+1] ) ) {
+                cycle_gamma= 1;
+            } else if ( 0 == strcmp( "w", argv[a+1] ) ) {
+                cycle_gamma= 2;
+            } else if ( 0 == strcmp( "f", argv[a+1] ) ) {
+                cycle_gamma= 1;
+                cycle_f= true;
+            } else {
+                cycle_gamma= std::max( 1, atoi( argv[a+1] ) );
+            }
+            ++a;
+            if ( 0 == dash::myid() ) {
+
+                cout << "using " << ( cycle_f ? "F" : "gamma= " + std::to_string( cycle_gamma ) ) <<
+                    " cycles" << endl;
+            }
+
+        } else if ( 0 == strncmp( "--fmg", argv[a], 5 ) ) {
+
+            use_fmg= true;
+            if ( 0 == dash::myid() ) {
+
+                cout << "start with full multigrid" << endl;
+            }
+
+        } else if ( 0 == strncmp( "--fuse", argv[a], 6 ) ) {
+
+            use_fused= true;
+            if ( 0 == dash::myid() ) {
+
+                cout << "fuse restriction and prolongation with the smoother" << endl;
+            }
+
+        } else if ( 0 == strncmp( "--mixed", argv[a], 7 ) ) {
+
+            use_mixed= true;
+            if ( 0 == dash::myid() ) {
+
+                cout << "use float on the coarser grids" << endl;
+            }
+
+        } else if ( 0 == strncmp( "--checkpoint", argv[a], 12 ) && ( a+2 < argc ) ) {
+
+            checkpoint_every= std::max( 0, atoi( argv[a+1] ) );
+            checkpoint_file= argv[a+2];
+            a += 2;
+            if ( 0 == dash::myid() ) {
+
+                cout << "write checkpoint " << checkpoint_file << " every " <<
+                    checkpoint_every << " output steps" << endl;
+            }
+
+        } else if ( 0 == strncmp( "--restart", argv[a], 9 ) && ( a+1 < argc ) ) {
+
+            restart_file= argv[a+1];
+            ++a;
+            if ( 0 == dash::myid() ) {
+
+                cout << "restart simulation from " << restart_file << endl;
+            }
+
         } else if ( 0 == strncmp( "--sim", argv[a], 5 ) && ( a+2 < argc ) ) {
 
             whattodo= SIM;
@@ -3958,6 +6917,30 @@ const char* HELPTEXT= "\n"
                     "interval " << timestep << endl;
             }
 
+        } else if ( 0 == strncmp( "--implicit", argv[a], 10 ) && ( a+2 < argc ) ) {
+
+            time_scheme= ( 0 == strcmp( "cn", argv[a+1] ) ) ? CRANK_NICOLSON : BACKWARD_EULER;
+            implicit_steps= std::max( 1, atoi( argv[a+2] ) );
+            a += 2;
+            if ( 0 == dash::myid() ) {
+
+                cout << "implicit time steps with " <<
+                    ( CRANK_NICOLSON == time_scheme ? "Crank-Nicolson" : "backward Euler" ) <<
+                    ", " << implicit_steps << " per output interval" << endl;
+            }
+
+        } else if ( 0 == strncmp( "--mgcg", argv[a], 6 ) ) {
+
+            whattodo= MGCG;
+            if ( a+1 < argc && 0 < atoi( argv[a+1] ) ) {
+                mgcg_sweeps= atoi( argv[a+1] );
+                ++a;
+            }
+            if ( 0 == dash::myid() ) {
+
+                cout << "do multigrid preconditioned CG with " << mgcg_sweeps << " sweeps" << endl;
+            }
+
         } else if ( 0 == strncmp( "-f", argv[a], 2  ) ||
                 0 == strncmp( "--flat", argv[a], 6 )) {
 
@@ -3988,7 +6971,23 @@ const char* HELPTEXT= "\n"
             if ( 0 == strncmp( "--elastic=", argv[a], 10 ) ) {
                 split_arg = argv[a] + 10;
             }
-            split = atoi(split_arg);
+            /* 0 or 'auto' for the cost model */
+            char* end= NULL;
+            long s= strtol( split_arg, &end, 10 );
+            if ( 0 == strcmp( "auto", split_arg ) ) {
+
+                split= 0;
+            } else if ( end != split_arg && '\0' == *end && 0 <= s ) {
+
+                split= s;
+            } else {
+
+                if ( 0 == dash::myid() ) {
+                    cerr << "invalid argument '" << argv[a] << "', expected -e<s>, --elastic=<s>, or --elastic=auto" << endl;
+                }
+                dash::finalize();
+                return 1;
+            }
 
         } else if ( 0 == strncmp( "--eps", argv[a], 5  ) && ( a+1 < argc ) ) {
 
@@ -4010,6 +7009,90 @@ const char* HELPTEXT= "\n"
             }
             for ( uint32_t i= 0; i < 3; ++i ) resolution[i]= (1<<g)+1;
 
+        } else if ( 0 == strncmp( "--asyncio", argv[a], 9  ) && ( a+1 < argc ) ) {
+
+            int q= std::max( 0, atoi( argv[a+1] ) );
+            ++a;
+#ifdef WITHCSVOUTPUT
+            if ( 0 < q ) {
+
+                async_writer= new AsyncWriter( q );
+                if ( 0 == dash::myid() ) {
+
+                    cout << "using background CSV output with up to " << q << " pending output steps" << endl;
+                }
+            }
+#else /* WITHCSVOUTPUT */
+            if ( 0 == dash::myid() ) {
+
+                cout << "ignore '--asyncio " << q << "', compiled without WITHCSVOUTPUT" << endl;
+            }
+#endif /* WITHCSVOUTPUT */
+
+        } else if ( 0 == strncmp( "--faces", argv[a], 7  ) ) {
+
+            per_face_halo= true;
+            if ( 0 == dash::myid() ) {
+
+                cout << "wait for the face halos one by one" << endl;
+            }
+
+        } else if ( 0 == strncmp( "--tile", argv[a], 6  ) && ( a+2 < argc ) ) {
+
+            tile_y= std::max( 0, atoi( argv[a+1] ) );
+            tile_x= std::max( 0, atoi( argv[a+2] ) );
+            a += 2;
+            if ( 0 == dash::myid() ) {
+
+                cout << "using cache tiles of " << tile_y << "×" << tile_x << " points" << endl;
+            }
+
+        } else if ( 0 == strncmp( "--threads", argv[a], 9  ) && ( a+1 < argc ) ) {
+
+            int t= std::max( 1, atoi( argv[a+1] ) );
+            ++a;
+#ifdef _OPENMP
+            omp_set_num_threads( t );
+            if ( 0 == dash::myid() ) {
+
+                cout << "using " << t << " threads per unit" << endl;
+            }
+#else
+            if ( 0 == dash::myid() ) {
+
+                cout << "ignore '--threads " << t << "', compiled without OpenMP" << endl;
+            }
+#endif
+
+        } else if ( 0 == strncmp( "--stream", argv[a], 8  ) ) {
+
+            with_stream= true;
+
+        } else if ( 0 == strncmp( "--tb", argv[a], 4  ) && ( a+1 < argc ) ) {
+
+            blocking_depth= std::max( 1, atoi( argv[a+1] ) );
+            ++a;
+            if ( 0 == dash::myid() ) {
+
+                cout << "using temporal blocking with " << blocking_depth <<
+                    " sweeps per halo exchange" << endl;
+            }
+
+        } else if ( 0 == strncmp( "--smoother", argv[a], 10  ) && ( a+1 < argc ) ) {
+
+            if ( 0 == strcmp( "rbgs", argv[a+1] ) ) {
+                smoother_kind= REDBLACK;
+            } else if ( 0 == strcmp( "cheby", argv[a+1] ) ) {
+                smoother_kind= CHEBYSHEV;
+            } else {
+                smoother_kind= JACOBI;
+            }
+            ++a;
+            if ( 0 == dash::myid() ) {
+
+                cout << "using smoother " << argv[a] << endl;
+            }
+
         } else if ( 0 == strncmp( "-d", argv[a], 2  ) && ( a+3 < argc ) ) {
 
             dimensions[0]= atof( argv[a+1] );
@@ -4038,6 +7121,89 @@ const char* HELPTEXT= "\n"
     assert( howmanylevels > 2 );
     assert( howmanylevels <= 16 ); /* please adapt if you really want to go so high */
 
+    if ( MGCG == whattodo && JACOBI != smoother_kind ) {
+
+        /* red-black Gauss-Seidel with one ordering and the Chebyshev smoother with
+        its estimated eigenvalue bounds do not give a symmetric preconditioner */
+        if ( 0 == dash::myid() ) {
+            cout << "multigrid preconditioned CG needs the damped Jacobi smoother, ignore '--smoother'" << endl;
+        }
+        smoother_kind= JACOBI;
+    }
+
+#ifndef USE_NEW_SCALEUP
+    if ( use_mixed ) {
+
+        if ( 0 == dash::myid() ) {
+            cout << "mixed precision needs the new scaleup (USE_NEW_SCALEUP), ignore '--mixed'" << endl;
+        }
+        use_mixed= false;
+    }
+#endif /* USE_NEW_SCALEUP */
+
+    if ( use_fmg && ( MULTIGRID != whattodo || use_mixed ) ) {
+
+        if ( 0 == dash::myid() ) {
+            cout << "full multigrid is only available in the plain multigrid mode " <<
+                "without '--elastic' and '--mixed', ignore '--fmg'" << endl;
+        }
+        use_fmg= false;
+    }
+
+    if ( 1 < blocking_depth && JACOBI != smoother_kind ) {
+
+        if ( 0 == dash::myid() ) {
+            cout << "temporal blocking is only available for the Jacobi smoother, ignore it" << endl;
+        }
+        blocking_depth= 1;
+    }
+
+    if ( 1 < blocking_depth ) {
+        tags.push_back("tb=" + std::to_string(blocking_depth));
+    }
+
+    if ( 0 < tile_y && 0 < tile_x ) {
+        tags.push_back("tile=" + std::to_string(tile_y) + "x" + std::to_string(tile_x));
+    } else {
+#ifdef _SC_LEVEL2_CACHE_SIZE
+        long l2= sysconf( _SC_LEVEL2_CACHE_SIZE );
+        if ( 0 < l2 ) {
+            cache_size= l2;
+        }
+#endif
+        if ( 0 == dash::myid() ) {
+            cout << "using automatic cache tiles for " << cache_size << " bytes of L2 cache" << endl;
+        }
+    }
+
+    /* memory bandwidth of every unit for the summary at the end, with the
+    number of threads set above */
+    if ( with_stream ) {
+
+        double stream= minimon.measure_stream();
+        if ( 0 == dash::myid() ) {
+            cout << "STREAM triad: " << stream * 1.0e-9 << " GB/s per unit, " <<
+                stream * 1.0e-9 * dash::Team::All().size() << " GB/s in total (unit 0 times all)" << endl;
+        }
+    }
+#ifdef _OPENMP
+    tags.push_back("threads=" + std::to_string(omp_get_max_threads()));
+#endif
+    if ( per_face_halo ) {
+        tags.push_back("faces");
+    }
+    if ( use_fused && JACOBI == smoother_kind ) {
+        tags.push_back("fused");
+    } else if ( use_fused ) {
+
+        if ( 0 == dash::myid() ) {
+            cout << "fused restriction and prolongation are only available for the Jacobi smoother, ignore it" << endl;
+        }
+        use_fused= false;
+    }
+    tags.push_back( std::string("smoother=") +
+        ( REDBLACK == smoother_kind ? "rbgs" : CHEBYSHEV == smoother_kind ? "cheby" : "jacobi" ) );
+
     std::string scaleup_kind =
 #ifdef USE_NEW_SCALEUP
         "new"
@@ -4055,6 +7221,14 @@ const char* HELPTEXT= "\n"
             tags.push_back("sim");
             tags.push_back("timerange=" + std::to_string(timerange));
             tags.push_back("timestep=" + std::to_string(timestep));
+            if ( EXPLICIT != time_scheme ) {
+                tags.push_back( CRANK_NICOLSON == time_scheme ? "implicit=cn" : "implicit=be" );
+                tags.push_back("steps=" + std::to_string(implicit_steps));
+                tags.push_back( cycle_f ? std::string("cycle=f") : "gamma=" + std::to_string(cycle_gamma) );
+                tags.push_back("eps=" + std::to_string(epsilon));
+                do_simulation_implicit( howmanylevels, timerange, timestep, epsilon, dimensions );
+                break;
+            }
             do_simulation( howmanylevels, timerange, timestep, dimensions );
             break;
         case FLAT:
@@ -4062,26 +7236,73 @@ const char* HELPTEXT= "\n"
             tags.push_back("eps=" + std::to_string(epsilon));
             do_flat_iteration( howmanylevels, epsilon, dimensions );
             break;
+        case MGCG:
+            tags.push_back("mgcg");
+            tags.push_back("sweeps=" + std::to_string(mgcg_sweeps));
+            tags.push_back("eps=" + std::to_string(epsilon));
+            do_mgcg( howmanylevels, epsilon, dimensions );
+            break;
         case ELASTICMULTIGRID:
             tags.push_back("multigridelastic");
+            tags.push_back( cycle_f ? std::string("cycle=f") : "gamma=" + std::to_string(cycle_gamma) );
             tags.push_back("eps=" + std::to_string(epsilon));
-            tags.push_back("split=" + std::to_string(split));
+            tags.push_back( ( 0 == split ) ? std::string("split=auto") : "split=" + std::to_string(split) );
             tags.push_back("scaleup=" + scaleup_kind);
             do_multigrid_elastic( howmanylevels, epsilon, dimensions, split );
             break;
         default:
             tags.push_back("multigrid");
+            tags.push_back( cycle_f ? std::string("cycle=f") : "gamma=" + std::to_string(cycle_gamma) );
+            if ( use_fmg ) {
+                tags.push_back("fmg");
+            }
             tags.push_back("eps=" + std::to_string(epsilon));
             tags.push_back("scaleup=" + scaleup_kind);
+#ifdef USE_NEW_SCALEUP
+            if ( use_mixed ) {
+                tags.push_back("mixed");
+                do_multigrid_mixed( howmanylevels, epsilon, dimensions );
+                break;
+            }
+#endif /* USE_NEW_SCALEUP */
             do_multigrid_iteration( howmanylevels, epsilon, dimensions );
     }
 
+    if ( 1 < blocking_depth && 0 == dash::myid() ) {
+
+        cout << "temporal blocking with depth " << blocking_depth << " avoided " <<
+            halo_exchanges_avoided << " halo exchanges" << endl;
+    }
+
+    if ( 0 == dash::myid() && 0 < level_pool.num_reused() ) {
+        cout << "level pool created " << level_pool.num_created() << " levels and reused " <<
+            level_pool.num_reused() << " times" << endl;
+    }
+
+    /* the pooled levels hold DASH memory, free them before dash::finalize() */
+    level_pool.clear();
+
 #ifdef WITHCSVOUTPUT
 
+    if ( NULL != async_writer ) {
+
+        /* wait for the pending output */
+        async_writer->finish();
+        if ( 0 == dash::myid() ) {
+            cout << "background CSV output stalled the computation for " <<
+                async_writer->stalled_seconds() << " s" << endl;
+        }
+        delete async_writer;
+        async_writer= NULL;
+    }
+
     delete filenumber;
 
 #endif /* WITHCSVOUTPUT */
 
+    /* min/avg/max over all units and achieved bandwidth and flop rate */
+    minimon.print_summary( tags );
+
     // dash::finalize
     minimon.start();
 
@@ -0,0 +1,244 @@
+#ifndef STENCILKERNEL_H
+#define STENCILKERNEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cmath>
+#include <algorithm>
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+/* Hand vectorized kernel for one x-row of the 7-point Poisson stencil as used
+by the Jacobi smoother. It computes
+
+    dtheta= m * ( ff*rhs - ax*(east+west) - ay*(north+south) - az*(up+down) - ac*center )
+    dst= center + c * dtheta
+
+for n consecutive points and returns max(|dtheta|) over the row. The maximum
+is kept in vector registers and only reduced horizontally once per row.
+
+With AVX-512 or AVX2 (as selected by -march=native) there is a scalar peel loop
+until the center pointer is aligned to the vector width, then the center and the
+up/down/north/south/rhs rows are read with aligned loads if they share the
+alignment of the center row, which is the case whenever the line length is a
+multiple of the vector width. The east and west neighbors are always unaligned.
+Without those instruction sets the portable scalar loop is used, which the
+compiler may still vectorize. Rows of other element types, i.e., float in
+mixed precision mode, always use the portable loop with the arithmetic in
+double and only the loads and stores in the element type.
+
+row_momentum() is the variant for the Chebyshev smoother, which also adds
+alpha * ( center - dst ) with the previous value of dst. It is the portable
+loop for all element types. */
+
+class StencilKernel7 {
+
+public:
+
+    double ax, ay, az, ac, ff, m, c;
+
+    StencilKernel7( double _ax, double _ay, double _az, double _ac,
+            double _ff, double _m, double _c ) :
+        ax(_ax), ay(_ay), az(_az), ac(_ac), ff(_ff), m(_m), c(_c) {}
+
+    /* sy and sz are the distances of the north/south and up/down neighbors,
+    signed since the kernel also reads at -sy and -sz */
+    double row( const double* __restrict core, const double* __restrict rhs,
+            double* __restrict dst, size_t n, std::ptrdiff_t sy, std::ptrdiff_t sz ) const {
+
+        double res= 0.0;
+        size_t x= 0;
+
+#if defined(__AVX512F__)
+        const size_t width= 8;
+        const uintptr_t mask= 64-1;
+#elif defined(__AVX2__)
+        const size_t width= 4;
+        const uintptr_t mask= 32-1;
+#endif
+
+#if defined(__AVX512F__) || defined(__AVX2__)
+        /* peel until core is aligned */
+        while ( x < n && 0 != ( reinterpret_cast<uintptr_t>( core + x ) & mask ) ) {
+            res= std::max( res, point( core + x, rhs[x], dst + x, sy, sz ) );
+            ++x;
+        }
+
+        /* all rows are aligned alike if the strides are multiples of the vector width */
+        bool aligned= ( 0 == sy % width ) && ( 0 == sz % width ) &&
+            0 == ( reinterpret_cast<uintptr_t>( rhs + x ) & mask );
+        if ( aligned ) {
+            x= vector_loop<true>( core, rhs, dst, x, n, sy, sz, res );
+        } else {
+            x= vector_loop<false>( core, rhs, dst, x, n, sy, sz, res );
+        }
+#endif
+
+        /* remainder, or everything for the portable version */
+        for ( ; x < n; ++x ) {
+            res= std::max( res, point( core + x, rhs[x], dst + x, sy, sz ) );
+        }
+
+        return res;
+    }
+
+    template< typename T >
+    double row( const T* __restrict core, const T* __restrict rhs,
+            T* __restrict dst, size_t n, std::ptrdiff_t sy, std::ptrdiff_t sz ) const {
+
+        double res= 0.0;
+        for ( size_t x= 0; x < n; ++x ) {
+            res= std::max( res, point( core + x, rhs[x], dst + x, sy, sz ) );
+        }
+
+        return res;
+    }
+
+    template< typename T >
+    double row_momentum( const T* __restrict core, const T* __restrict rhs,
+            T* __restrict dst, size_t n, std::ptrdiff_t sy, std::ptrdiff_t sz,
+            double alpha ) const {
+
+        double res= 0.0;
+        for ( size_t x= 0; x < n; ++x ) {
+
+            const T* p= core + x;
+            double dtheta= defect( p, rhs[x], sy, sz );
+            dst[x]= *p + c * dtheta + alpha * ( *p - dst[x] );
+            res= std::max( res, std::fabs( dtheta ) );
+        }
+
+        return res;
+    }
+
+private:
+
+    template< typename T >
+    inline double defect( const T* p, double rhs, std::ptrdiff_t sy, std::ptrdiff_t sz ) const {
+
+        return m * (
+            ff * rhs -
+            ax * ( p[1] + p[-1] ) -
+            ay * ( p[sy] + p[-sy] ) -
+            az * ( p[sz] + p[-sz] ) -
+            ac * *p );
+    }
+
+    template< typename T >
+    inline double point( const T* p, double rhs, T* dst, std::ptrdiff_t sy, std::ptrdiff_t sz ) const {
+
+        double dtheta= defect( p, rhs, sy, sz );
+        *dst= *p + c * dtheta;
+
+        return std::fabs( dtheta );
+    }
+
+#if defined(__AVX512F__)
+
+    template<bool ALIGNED>
+    static inline __m512d load( const double* p ) {
+        return ALIGNED ? _mm512_load_pd( p ) : _mm512_loadu_pd( p );
+    }
+
+    /* returns the first index not handled */
+    template<bool ALIGNED>
+    size_t vector_loop( const double* __restrict core, const double* __restrict rhs,
+            double* __restrict dst, size_t x, size_t n, std::ptrdiff_t sy, std::ptrdiff_t sz, double& res ) const {
+
+        const __m512d vax= _mm512_set1_pd( ax );
+        const __m512d vay= _mm512_set1_pd( ay );
+        const __m512d vaz= _mm512_set1_pd( az );
+        const __m512d vac= _mm512_set1_pd( ac );
+        const __m512d vff= _mm512_set1_pd( ff );
+        const __m512d vm=  _mm512_set1_pd( m );
+        const __m512d vc=  _mm512_set1_pd( c );
+        __m512d vres= _mm512_setzero_pd();
+
+        for ( ; x + 8 <= n; x += 8 ) {
+
+            const double* p= core + x;
+            __m512d center= _mm512_load_pd( p );
+            __m512d ew= _mm512_add_pd( _mm512_loadu_pd( p + 1 ), _mm512_loadu_pd( p - 1 ) );
+            __m512d ns= _mm512_add_pd( load<ALIGNED>( p + sy ), load<ALIGNED>( p - sy ) );
+            __m512d ud= _mm512_add_pd( load<ALIGNED>( p + sz ), load<ALIGNED>( p - sz ) );
+
+            __m512d t= _mm512_mul_pd( vff, load<ALIGNED>( rhs + x ) );
+            t= _mm512_fnmadd_pd( vax, ew, t );
+            t= _mm512_fnmadd_pd( vay, ns, t );
+            t= _mm512_fnmadd_pd( vaz, ud, t );
+            t= _mm512_fnmadd_pd( vac, center, t );
+            __m512d dtheta= _mm512_mul_pd( vm, t );
+
+            _mm512_storeu_pd( dst + x, _mm512_fmadd_pd( vc, dtheta, center ) );
+            vres= _mm512_max_pd( vres, _mm512_abs_pd( dtheta ) );
+        }
+
+        res= std::max( res, _mm512_reduce_max_pd( vres ) );
+        return x;
+    }
+
+#elif defined(__AVX2__)
+
+    template<bool ALIGNED>
+    static inline __m256d load( const double* p ) {
+        return ALIGNED ? _mm256_load_pd( p ) : _mm256_loadu_pd( p );
+    }
+
+    /* returns the first index not handled */
+    template<bool ALIGNED>
+    size_t vector_loop( const double* __restrict core, const double* __restrict rhs,
+            double* __restrict dst, size_t x, size_t n, std::ptrdiff_t sy, std::ptrdiff_t sz, double& res ) const {
+
+        const __m256d vax= _mm256_set1_pd( ax );
+        const __m256d vay= _mm256_set1_pd( ay );
+        const __m256d vaz= _mm256_set1_pd( az );
+        const __m256d vac= _mm256_set1_pd( ac );
+        const __m256d vff= _mm256_set1_pd( ff );
+        const __m256d vm=  _mm256_set1_pd( m );
+        const __m256d vc=  _mm256_set1_pd( c );
+        const __m256d signmask= _mm256_set1_pd( -0.0 );
+        __m256d vres= _mm256_setzero_pd();
+
+        for ( ; x + 4 <= n; x += 4 ) {
+
+            const double* p= core + x;
+            __m256d center= _mm256_load_pd( p );
+            __m256d ew= _mm256_add_pd( _mm256_loadu_pd( p + 1 ), _mm256_loadu_pd( p - 1 ) );
+            __m256d ns= _mm256_add_pd( load<ALIGNED>( p + sy ), load<ALIGNED>( p - sy ) );
+            __m256d ud= _mm256_add_pd( load<ALIGNED>( p + sz ), load<ALIGNED>( p - sz ) );
+
+            __m256d t= _mm256_mul_pd( vff, load<ALIGNED>( rhs + x ) );
+#ifdef __FMA__
+            t= _mm256_fnmadd_pd( vax, ew, t );
+            t= _mm256_fnmadd_pd( vay, ns, t );
+            t= _mm256_fnmadd_pd( vaz, ud, t );
+            t= _mm256_fnmadd_pd( vac, center, t );
+            __m256d dtheta= _mm256_mul_pd( vm, t );
+            _mm256_storeu_pd( dst + x, _mm256_fmadd_pd( vc, dtheta, center ) );
+#else
+            t= _mm256_sub_pd( t, _mm256_mul_pd( vax, ew ) );
+            t= _mm256_sub_pd( t, _mm256_mul_pd( vay, ns ) );
+            t= _mm256_sub_pd( t, _mm256_mul_pd( vaz, ud ) );
+            t= _mm256_sub_pd( t, _mm256_mul_pd( vac, center ) );
+            __m256d dtheta= _mm256_mul_pd( vm, t );
+            _mm256_storeu_pd( dst + x, _mm256_add_pd( center, _mm256_mul_pd( vc, dtheta ) ) );
+#endif
+            vres= _mm256_max_pd( vres, _mm256_andnot_pd( signmask, dtheta ) );
+        }
+
+        /* horizontal maximum */
+        __m128d hi= _mm256_extractf128_pd( vres, 1 );
+        __m128d lo= _mm256_castpd256_pd128( vres );
+        __m128d m2= _mm_max_pd( hi, lo );
+        m2= _mm_max_sd( m2, _mm_unpackhi_pd( m2, m2 ) );
+        res= std::max( res, _mm_cvtsd_f64( m2 ) );
+        return x;
+    }
+
+#endif
+
+};
+
+#endif /* STENCILKERNEL_H */